@@ -0,0 +1,642 @@
+#include <random>
+#include <spanstream>
+#include "Engine/Core.h"
+#include "Engine/Logging.h"
+#include "Engine/Reflection.h"
+#include "Engine/StringID.h"
+#include "Engine/Temporary.h"
+#include "Rendering/StaticMesh.h"
+#include "Resources/Cache.h"
+#include "Resources/PackageIO.h"
+#include "Resources/Streaming.h"
+#include "Resources/Text.h"
+
+LOG_CATEGORY(Benchmarks, Debug);
+
+using namespace Rendering;
+using namespace Resources;
+
+//Every allocation made by the program is counted, so benchmarks can report how many allocations were made while they were running
+static std::atomic<size_t> num_allocations = 0;
+
+void* operator new(size_t size) {
+	num_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* const pointer = std::malloc(std::max<size_t>(size, 1))) return pointer;
+	throw std::bad_alloc{};
+}
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+/** Measure the time taken by a function */
+template<typename FunctionType>
+static Milliseconds Measure(FunctionType&& function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::steady_clock::now() - start;
+}
+
+/** Assign the same small amount of data to a mesh that the default plane mesh uses, so each mesh also owns memory outside of the mesh object */
+static void InitializePlane(StaticMesh& mesh) {
+	mesh.vertices.emplace<Vertices_Simple>(4);
+	mesh.indices.emplace<Indices_Short>() = { 0, 1, 2, 2, 3, 0 };
+}
+
+/** Read a value from each mesh object without following pointers to any data the mesh owns */
+static size_t Touch(StaticMesh const& mesh) {
+	return mesh.vertices.index() + mesh.indices.index() + (mesh.objects ? 1 : 0);
+}
+
+/** Create text that compresses about as well as ordinary text, which differs for each seed */
+static std::string CreateText(size_t seed, size_t size) {
+	std::string text;
+	text.reserve(size + 128);
+	for (size_t line = 0; text.size() < size; ++line) {
+		std::format_to(std::back_inserter(text), "Line {} of text {}: the resource stores {} characters and is checked by value {}.\n", line, seed, size, (seed * 7919 + line * 104729) % 65536);
+	}
+	text.resize(size);
+	return text;
+}
+
+/** Create the source of a binary package with the provided contents and dependencies. The dependencies are listed even though the resources do not refer to them. */
+static std::vector<std::byte> CreateBinarySource(Package::ContentsContainerType const& contents, std::unordered_set<StringID> const& dependencies, BinaryPackageSettings const& settings = BinaryPackageSettings{}) {
+	PackageOutput_Binary const output{ contents, settings };
+
+	//The header is written again with the dependencies, replacing the header which was written with no dependencies
+	std::vector<std::byte> source;
+	Archive::Output archive{ source };
+	archive << BinaryPackageMagic << std::to_underlying(EBinaryPackageVersion::Current) << std::unordered_set<StringID>{};
+	size_t const replaced = source.size();
+
+	source.clear();
+	archive << BinaryPackageMagic << std::to_underlying(EBinaryPackageVersion::Current) << dependencies;
+	source.insert(source.end(), output.bytes.begin() + replaced, output.bytes.end());
+	return source;
+}
+
+/** Streams packages from sources that are kept in memory, so benchmarks measure streaming without waiting for the filesystem */
+struct MemoryStreamingDatabase : public StreamingDatabase {
+	using SourcesContainerType = std::unordered_map<StringID, std::vector<std::byte>>;
+
+	MemoryStreamingDatabase(SourcesContainerType const& sources, size_t num_workers) : StreamingDatabase(num_workers), sources(sources) {}
+	~MemoryStreamingDatabase() { StopStreaming(); }
+
+	PackageRequestHandle LoadPackage(StringID name, RequestPriority priority = DefaultRequestPriority) { return StreamingDatabase::LoadPackage(name, priority); }
+
+protected:
+	virtual size_t EstimatePackageSourceSize(StringID name) const override final {
+		auto const iter = sources.find(name);
+		return iter != sources.end() ? iter->second.size() : 0;
+	}
+	virtual void SavePackageContents(StringID name, Package::ContentsContainerType const& contents, std::atomic<float>& progress) override final {
+		throw FormatType<std::runtime_error>("Unable to save package {}, benchmark packages cannot be modified", name);
+	}
+	virtual PackageInput LoadPackageSource(StringID name) override final {
+		auto const iter = sources.find(name);
+		if (iter == sources.end()) throw FormatType<std::runtime_error>("Package {} not found, unable to load package source", name);
+
+		std::ispanstream stream{ stdext::from_bytes<char>(std::span<std::byte const>{ iter->second }) };
+		return PackageInput_Binary{ stream };
+	}
+
+private:
+	SourcesContainerType const& sources;
+};
+
+/**
+ * One writer thread creates resources while four reader threads repeatedly iterate over the cache. The writer also releases older resources and collects garbage,
+ * so resources are evicted while readers are iterating. Readers never wait for the writer, so the writer should not slow down as readers are added.
+ */
+static void BenchmarkConcurrentIteration() {
+	constexpr size_t NumResources = 100'000;
+	constexpr size_t NumReaders = 4;
+	//The writer releases the oldest handles once it holds this many, keeping the remaining resources in use
+	constexpr size_t NumHeld = 50'000;
+	constexpr size_t CollectInterval = 1'000;
+
+	TCache<StaticMesh> cache;
+	std::atomic<bool> writing = true;
+	std::atomic<size_t> num_iterations = 0;
+	std::atomic<size_t> num_visited = 0;
+	Milliseconds write_duration{};
+	Milliseconds read_duration{};
+
+	{
+		std::vector<std::jthread> readers;
+		for (size_t index = 0; index < NumReaders; ++index) {
+			readers.emplace_back([&]() {
+				while (writing.load(std::memory_order_relaxed)) {
+					size_t visited = 0;
+					cache.ForEachResource([&](StaticMesh& mesh) { visited += Touch(mesh) + 1; return true; });
+					num_visited += visited;
+					++num_iterations;
+				}
+			});
+		}
+
+		read_duration = Measure([&]() {
+			write_duration = Measure([&]() {
+				std::deque<std::shared_ptr<Resource>> handles;
+				for (size_t index = 0; index < NumResources; ++index) {
+					handles.emplace_back(cache.Create("SM_Benchmark"_sid, [](Resource& resource) { InitializePlane(static_cast<StaticMesh&>(resource)); }));
+
+					if (handles.size() > NumHeld) handles.pop_front();
+					if ((index % CollectInterval) == 0) cache.CollectGarbage();
+				}
+			});
+			writing = false;
+			readers.clear();
+		});
+	}
+
+	LOG(Benchmarks, Info, "Concurrent iteration: writer created {} resources in {:.1f} ms ({:.0f} per second) while {} readers iterated",
+		NumResources, write_duration.count(), NumResources / (write_duration.count() / 1000.0), NumReaders);
+	LOG(Benchmarks, Info, "Concurrent iteration: readers completed {} iterations and visited {} resources ({:.0f} per second per reader)",
+		num_iterations.load(), num_visited.load(), num_visited.load() / (read_duration.count() / 1000.0) / NumReaders);
+	LOG(Benchmarks, Info, "Concurrent iteration: {} resources evicted while readers were iterating", cache.GetStatistics().num_evicted);
+}
+
+/**
+ * Create 100k meshes with a separate allocation for each mesh, as caches did before resources were pooled, then create the same meshes in a cache which uses a pool.
+ * Reports the number of allocations made while creating the meshes and the time taken to read each mesh object.
+ */
+static void BenchmarkPooledAllocation() {
+	constexpr size_t NumMeshes = 100'000;
+	constexpr size_t NumPasses = 20;
+
+	//Separate allocations
+	{
+		std::vector<std::shared_ptr<StaticMesh>> meshes;
+		meshes.reserve(NumMeshes);
+
+		size_t const allocations_before = num_allocations;
+		Milliseconds const create_duration = Measure([&]() {
+			for (size_t index = 0; index < NumMeshes; ++index) {
+				std::shared_ptr<StaticMesh> const& mesh = meshes.emplace_back(std::make_shared<StaticMesh>("SM_Benchmark"_sid));
+				InitializePlane(*mesh);
+			}
+		});
+		size_t const allocations = num_allocations - allocations_before;
+
+		size_t total = 0;
+		Milliseconds const iterate_duration = Measure([&]() {
+			for (size_t pass = 0; pass < NumPasses; ++pass) {
+				for (std::shared_ptr<StaticMesh> const& mesh : meshes) total += Touch(*mesh);
+			}
+		});
+
+		LOG(Benchmarks, Info, "Separate allocation: created {} meshes in {:.1f} ms with {} allocations ({:.2f} per mesh)",
+			NumMeshes, create_duration.count(), allocations, static_cast<double>(allocations) / NumMeshes);
+		LOG(Benchmarks, Info, "Separate allocation: iterated handles in {:.2f} ns per mesh (checksum {})",
+			iterate_duration.count() * 1'000'000.0 / (NumMeshes * NumPasses), total);
+	}
+
+	//Pooled allocations
+	{
+		TCache<StaticMesh> cache;
+		std::vector<std::shared_ptr<Resource>> meshes;
+		meshes.reserve(NumMeshes);
+
+		size_t const allocations_before = num_allocations;
+		Milliseconds const create_duration = Measure([&]() {
+			for (size_t index = 0; index < NumMeshes; ++index) {
+				meshes.emplace_back(cache.Create("SM_Benchmark"_sid, [](Resource& resource) { InitializePlane(static_cast<StaticMesh&>(resource)); }));
+			}
+		});
+		size_t const allocations = num_allocations - allocations_before;
+
+		size_t total = 0;
+		Milliseconds const iterate_duration = Measure([&]() {
+			for (size_t pass = 0; pass < NumPasses; ++pass) {
+				for (std::shared_ptr<Resource> const& mesh : meshes) total += Touch(static_cast<StaticMesh const&>(*mesh));
+			}
+		});
+		Milliseconds const cache_duration = Measure([&]() {
+			for (size_t pass = 0; pass < NumPasses; ++pass) {
+				cache.ForEachResource([&](StaticMesh& mesh) { total += Touch(mesh); return true; });
+			}
+		});
+
+		LOG(Benchmarks, Info, "Pooled allocation: created {} meshes in {:.1f} ms with {} allocations ({:.2f} per mesh), including cache bookkeeping",
+			NumMeshes, create_duration.count(), allocations, static_cast<double>(allocations) / NumMeshes);
+		LOG(Benchmarks, Info, "Pooled allocation: iterated handles in {:.2f} ns per mesh, iterated the cache in {:.2f} ns per mesh (checksum {})",
+			iterate_duration.count() * 1'000'000.0 / (NumMeshes * NumPasses), cache_duration.count() * 1'000'000.0 / (NumMeshes * NumPasses), total);
+	}
+}
+
+/**
+ * Stream a graph of 500 packages, where each package depends on up to three packages created before it and one package depends on every package that nothing else depends on.
+ * Requesting that package streams the whole graph. The graph is streamed with one worker, and then with more workers up to the number of hardware threads.
+ */
+static void BenchmarkDependencyGraph() {
+	constexpr size_t NumPackages = 500;
+	constexpr size_t MaxDependencies = 3;
+	//Dependencies are chosen from this many packages created before each package, so the graph has many layers instead of depending mostly on the first packages
+	constexpr size_t DependencyWindow = 50;
+	constexpr size_t NumResources = 4;
+	constexpr size_t TextSize = 4096;
+
+	std::mt19937 random{ 500 };
+	std::vector<StringID> names;
+	std::vector<bool> has_dependents(NumPackages, false);
+	MemoryStreamingDatabase::SourcesContainerType sources;
+
+	for (size_t index = 0; index < NumPackages; ++index) {
+		std::string const package_name = std::format("Benchmark/Graph{}", index);
+		StringID const name = names.emplace_back(package_name);
+
+		std::unordered_set<StringID> dependencies;
+		if (index == NumPackages - 1) {
+			for (size_t other = 0; other < index; ++other) {
+				if (!has_dependents[other]) dependencies.emplace(names[other]);
+			}
+
+		} else if (index > 0) {
+			std::uniform_int_distribution<size_t> distribution{ index - std::min(index, DependencyWindow), index - 1 };
+			for (size_t dependency = 0; dependency < MaxDependencies; ++dependency) {
+				size_t const other = distribution(random);
+				dependencies.emplace(names[other]);
+				has_dependents[other] = true;
+			}
+		}
+
+		//Resource names must be unique across packages, so they include the name of the package
+		Package::ContentsContainerType contents;
+		for (size_t resource_index = 0; resource_index < NumResources; ++resource_index) {
+			StringID const resource_name{ std::format("{}/Text{}", package_name, resource_index) };
+			auto const text = std::make_shared<Text>(resource_name);
+			text->string = CreateText(index * NumResources + resource_index, TextSize);
+			contents.emplace(resource_name, text);
+		}
+
+		sources.emplace(name, CreateBinarySource(contents, dependencies));
+	}
+
+	size_t const max_workers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	std::vector<size_t> worker_counts;
+	for (size_t num_workers = 1; num_workers < max_workers; num_workers *= 2) worker_counts.emplace_back(num_workers);
+	worker_counts.emplace_back(max_workers);
+
+	for (size_t const num_workers : worker_counts) {
+		auto const database = std::make_shared<MemoryStreamingDatabase>(sources, num_workers);
+
+		bool loaded = false;
+		Milliseconds const duration = Measure([&]() {
+			loaded = database->LoadPackage(names.back()).Wait() != nullptr;
+		});
+		StreamingStatistics const statistics = database->GetStreamingStats();
+
+		LOG(Benchmarks, Info, "Dependency graph: {} workers streamed {} packages in {:.1f} ms ({} failed, root {})",
+			num_workers, statistics.num_loaded, duration.count(), statistics.num_failed, loaded ? "loaded" : "failed");
+		LOG(Benchmarks, Info, "Dependency graph: {} workers waited {} us for dependencies and decoded in {} us at the 90th percentile, at most {} sources were prefetched",
+			num_workers, statistics.waiting.p90.count(), statistics.decoding.p90.count(), statistics.max_prefetched);
+	}
+}
+
+/**
+ * File 10k package requests with random priorities, then request a random tenth of the packages again at the highest priority, which raises them and their dependencies.
+ * Reports the time taken to file the requests, and how long the raised requests took to load compared to all requests.
+ */
+static void BenchmarkRequestPriorities() {
+	constexpr size_t NumPackages = 10'000;
+	constexpr size_t NumRaised = NumPackages / 10;
+	constexpr size_t MaxDependencies = 2;
+	constexpr size_t TextSize = 256;
+
+	std::mt19937 random{ 10'000 };
+	std::vector<StringID> names;
+	MemoryStreamingDatabase::SourcesContainerType sources;
+
+	for (size_t index = 0; index < NumPackages; ++index) {
+		std::string const package_name = std::format("Benchmark/Priority{}", index);
+		StringID const name = names.emplace_back(package_name);
+
+		//Dependencies form chains through the packages, so raising a package also raises packages that were requested at a lower priority
+		std::unordered_set<StringID> dependencies;
+		if (index > 0) {
+			std::uniform_int_distribution<size_t> distribution{ 0, index - 1 };
+			for (size_t dependency = 0; dependency < MaxDependencies; ++dependency) dependencies.emplace(names[distribution(random)]);
+		}
+
+		StringID const resource_name{ std::format("{}/Text", package_name) };
+		auto const text = std::make_shared<Text>(resource_name);
+		text->string = CreateText(index, TextSize);
+
+		sources.emplace(name, CreateBinarySource(Package::ContentsContainerType{ { resource_name, text } }, dependencies));
+	}
+
+	std::vector<RequestPriority> priorities;
+	std::uniform_int_distribution<uint32_t> priority_distribution{ LowestRequestPriority, DefaultRequestPriority };
+	for (size_t index = 0; index < NumPackages; ++index) priorities.emplace_back(static_cast<RequestPriority>(priority_distribution(random)));
+
+	std::vector<size_t> raised;
+	std::uniform_int_distribution<size_t> index_distribution{ 0, NumPackages - 1 };
+	for (size_t index = 0; index < NumRaised; ++index) raised.emplace_back(index_distribution(random));
+
+	auto const database = std::make_shared<MemoryStreamingDatabase>(sources, StreamingDatabase::GetDefaultWorkerCount());
+
+	std::vector<PackageRequestHandle> handles;
+	handles.reserve(NumPackages + NumRaised);
+
+	Milliseconds raised_duration{};
+	Milliseconds const total_duration = Measure([&]() {
+		Milliseconds const request_duration = Measure([&]() {
+			for (size_t index = 0; index < NumPackages; ++index) handles.emplace_back(database->LoadPackage(names[index], priorities[index]));
+		});
+		Milliseconds const raise_duration = Measure([&]() {
+			for (size_t const index : raised) handles.emplace_back(database->LoadPackage(names[index], HighestRequestPriority));
+		});
+
+		LOG(Benchmarks, Info, "Request priorities: filed {} requests in {:.1f} ms ({:.2f} us per request), raised {} requests in {:.1f} ms ({:.2f} us per request)",
+			NumPackages, request_duration.count(), request_duration.count() * 1000.0 / NumPackages, NumRaised, raise_duration.count(), raise_duration.count() * 1000.0 / NumRaised);
+
+		raised_duration = Measure([&]() {
+			for (size_t index = NumPackages; index < handles.size(); ++index) handles[index].Wait();
+		});
+		for (PackageRequestHandle& handle : handles) handle.Wait();
+	});
+	StreamingStatistics const statistics = database->GetStreamingStats();
+
+	LOG(Benchmarks, Info, "Request priorities: raised requests finished {:.1f} ms after they were filed, all {} packages loaded in {:.1f} ms ({} failed)",
+		raised_duration.count(), statistics.num_loaded, total_duration.count(), statistics.num_failed);
+	LOG(Benchmarks, Info, "Request priorities: requests were queued for {} us at the 50th percentile and {} us at the 99th percentile, at most {} requests were queued",
+		statistics.queued.p50.count(), statistics.queued.p99.count(), statistics.max_queued);
+}
+
+/**
+ * Save and load a package of 64 text resources of 64 KB each without compression, then with the block codec.
+ * Loading reads the table of contents, decompresses each resource and deserializes it, which is the work done on the streaming threads.
+ */
+static void BenchmarkCompression() {
+	constexpr size_t NumResources = 64;
+	constexpr size_t TextSize = 64 * 1024;
+	constexpr size_t NumPasses = 10;
+
+	Package::ContentsContainerType contents;
+	for (size_t index = 0; index < NumResources; ++index) {
+		StringID const name{ std::format("Benchmark/Compressed/Text{}", index) };
+		auto const text = std::make_shared<Text>(name);
+		text->string = CreateText(index, TextSize);
+		contents.emplace(name, text);
+	}
+
+	for (Compression::CodecID const codec : { Compression::NoCodec, Compression::BlockCodec }) {
+		BinaryPackageSettings const settings{ .codec = codec };
+
+		std::vector<std::byte> bytes;
+		Milliseconds const save_duration = Measure([&]() {
+			for (size_t pass = 0; pass < NumPasses; ++pass) bytes = PackageOutput_Binary{ contents, settings }.bytes;
+		});
+
+		size_t total = 0;
+		Milliseconds const load_duration = Measure([&]() {
+			std::vector<std::byte> decompressed;
+			for (size_t pass = 0; pass < NumPasses; ++pass) {
+				std::ispanstream stream{ stdext::from_bytes<char>(std::span<std::byte const>{ bytes }) };
+				PackageInput_Binary const source{ stream };
+
+				for (auto const& [id, type_reference, data] : source.GetContentsInformation()) {
+					Text text{ id };
+					Archive::Input archive{ data.Decompress(decompressed) };
+					Reflect<Text>::Get().Deserialize(archive, &text);
+					total += text.string.size();
+				}
+			}
+		});
+
+		LOG(Benchmarks, Info, "Compression: {} saved {} resources into {} bytes ({:.1f}% of uncompressed) in {:.2f} ms, loaded them in {:.2f} ms (checksum {})",
+			codec == Compression::NoCodec ? "no codec" : "block codec", NumResources, bytes.size(), bytes.size() * 100.0 / (NumResources * TextSize), save_duration.count() / NumPasses, load_duration.count() / NumPasses, total);
+	}
+}
+
+/** A small struct with a base type, similar to the many small structs that are serialized within larger objects */
+struct SmallStructBase {
+	DECLARE_STRUCT_REFLECTION_MEMBERS(SmallStructBase, void);
+	virtual ~SmallStructBase() = default;
+	bool operator==(SmallStructBase const&) const = default;
+
+	int32_t identifier = 0;
+	float weight = 1.0f;
+};
+REFLECT(SmallStructBase, Struct);
+DEFINE_DEFAULT_ARCHIVE_SERIALIZATION(SmallStructBase);
+DEFINE_DEFAULT_YAML_SERIALIZATION(SmallStructBase);
+
+struct SmallStruct : public SmallStructBase {
+	DECLARE_STRUCT_REFLECTION_MEMBERS(SmallStruct, SmallStructBase);
+	bool operator==(SmallStruct const&) const = default;
+
+	int32_t count = 0;
+	uint16_t flags = 0;
+	bool enabled = true;
+};
+REFLECT(SmallStruct, Struct);
+DEFINE_DEFAULT_ARCHIVE_SERIALIZATION(SmallStruct);
+DEFINE_DEFAULT_YAML_SERIALIZATION(SmallStruct);
+
+::Reflection::StructTypeInfo const& ::Reflect<::SmallStructBase>::Get() { return ::SmallStructBase::info_SmallStructBase; }
+::Reflection::TStructTypeInfo<::SmallStructBase> const ::SmallStructBase::info_SmallStructBase{
+	u"::SmallStructBase"sv, u"Small Struct Base"sv, std::in_place_type<::SmallStructBase::BaseType>,
+	{
+		MakeMember(&SmallStructBase::identifier, "identifier"_h32, u"identifier"sv, u""sv),
+		MakeMember(&SmallStructBase::weight, "weight"_h32, u"weight"sv, u""sv)
+	}
+};
+
+::Reflection::StructTypeInfo const& ::Reflect<::SmallStruct>::Get() { return ::SmallStruct::info_SmallStruct; }
+::Reflection::TStructTypeInfo<::SmallStruct> const ::SmallStruct::info_SmallStruct{
+	u"::SmallStruct"sv, u"Small Struct"sv, std::in_place_type<::SmallStruct::BaseType>,
+	{
+		MakeMember(&SmallStruct::count, "count"_h32, u"count"sv, u""sv),
+		MakeMember(&SmallStruct::flags, "flags"_h32, u"flags"sv, u""sv),
+		MakeMember(&SmallStruct::enabled, "enabled"_h32, u"enabled"sv, u""sv)
+	}
+};
+
+/**
+ * Serialize a struct the way structs were serialized before they had a serialization plan. The base types are walked and every variable is accessed
+ * through its variable info for each instance. The bytes are the same as serializing with the plan.
+ */
+static void SerializeWithoutPlan(Reflection::StructTypeInfo const& type, Archive::Output& archive, void const* instance) {
+	using namespace Reflection;
+
+	//The marker which identifies variables by id, which the plan writes at the start of each struct
+	archive << std::numeric_limits<size_t>::max();
+
+	void const* const defaults = type.GetDefaults();
+	bool const skip_defaults = defaults && type.flags.Has(ETypeFlags::EqualityComparable);
+
+	for (StructTypeInfo const* current = &type; current; current = current->base) {
+		for (std::unique_ptr<VariableInfo const> const& variable : current->GetVariables()) {
+			if (variable->flags.Has(EVariableFlags::Deprecated)) continue;
+
+			void const* const value = variable->GetImmutable(instance);
+			if (skip_defaults && variable->type->Equal(value, variable->GetImmutable(defaults))) continue;
+
+			size_t const start = archive.Size();
+			archive << variable->id;
+
+			Archive::Section const section = Archive::BeginSection(archive);
+			variable->type->Serialize(archive, value);
+			if (Archive::EndSection(archive, section) == 0) Archive::Rewind(archive, start);
+		}
+	}
+
+	archive << Hash32{};
+	Archive::EndSection(archive, Archive::BeginSection(archive));
+}
+
+/** Deserialize a struct the way structs were deserialized before they had a serialization plan, searching the base types for each variable that was read */
+static void DeserializeWithoutPlan(Reflection::StructTypeInfo const& type, Archive::Input& archive, void* instance) {
+	using namespace Reflection;
+
+	size_t marker = 0;
+	archive >> marker;
+
+	Hash32 id;
+	while (true) {
+		archive >> id;
+		Archive::Input subarchive = Archive::ReadSection(archive);
+		if (subarchive.Remaining() == 0) break;
+
+		for (StructTypeInfo const* current = &type; current; current = current->base) {
+			auto const iter = ranges::find_if(current->GetVariables(), [id](std::unique_ptr<VariableInfo const> const& variable) { return variable->id == id; });
+			if (iter != current->GetVariables().end()) {
+				if (void* pointer = (*iter)->GetMutable(instance)) (*iter)->type->Deserialize(subarchive, pointer);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Serialize and deserialize 1M small structs without a serialization plan, as structs were serialized before, then with the plan that is built for each struct type.
+ * Both write the same bytes, which is checked along with the values that were read back.
+ */
+static void BenchmarkStructSerialization() {
+	constexpr size_t NumStructs = 1'000'000;
+
+	Reflection::StructTypeInfo const& type = Reflect<SmallStruct>::Get();
+
+	std::vector<SmallStruct> values(NumStructs);
+	for (size_t index = 0; index < NumStructs; ++index) {
+		SmallStruct& value = values[index];
+		value.identifier = static_cast<int32_t>(index);
+		value.weight = static_cast<float>(index % 100) * 0.25f;
+		value.count = static_cast<int32_t>(index % 7);
+		value.flags = static_cast<uint16_t>(index & 0xFF);
+		//Most structs leave this at its default value, so it is skipped when they are serialized
+		value.enabled = (index % 16) != 0;
+	}
+
+	std::vector<std::byte> before_bytes;
+	std::vector<SmallStruct> before_values(NumStructs);
+	Milliseconds const before_write = Measure([&]() {
+		Archive::Output archive{ before_bytes };
+		for (SmallStruct const& value : values) SerializeWithoutPlan(type, archive, &value);
+	});
+	Milliseconds const before_read = Measure([&]() {
+		Archive::Input archive{ std::span<std::byte const>{ before_bytes } };
+		for (SmallStruct& value : before_values) DeserializeWithoutPlan(type, archive, &value);
+	});
+
+	std::vector<std::byte> plan_bytes;
+	std::vector<SmallStruct> plan_values(NumStructs);
+	Milliseconds const plan_write = Measure([&]() {
+		Archive::Output archive{ plan_bytes };
+		for (SmallStruct const& value : values) archive << value;
+	});
+	Milliseconds const plan_read = Measure([&]() {
+		Archive::Input archive{ std::span<std::byte const>{ plan_bytes } };
+		for (SmallStruct& value : plan_values) archive >> value;
+	});
+
+	bool const matches = before_bytes == plan_bytes && before_values == values && plan_values == values;
+
+	LOG(Benchmarks, Info, "Struct serialization: without a plan, wrote {} structs in {:.1f} ms and read them in {:.1f} ms",
+		NumStructs, before_write.count(), before_read.count());
+	LOG(Benchmarks, Info, "Struct serialization: with a plan, wrote {} structs in {:.1f} ms and read them in {:.1f} ms ({} bytes, {})",
+		NumStructs, plan_write.count(), plan_read.count(), plan_bytes.size(), matches ? "results match" : "RESULTS DIFFER");
+}
+
+/**
+ * Serialize 1M vertices one element at a time, as arrays were serialized before they could be copied as a block, then through the serializer for the vertex array.
+ * Both write the same bytes, which is checked along with the vertices that were read back.
+ */
+static void BenchmarkBulkArrays() {
+	constexpr size_t NumVertices = 1'000'000;
+	constexpr size_t NumPasses = 10;
+
+	Vertices_Simple vertices;
+	vertices.reserve(NumVertices);
+	for (size_t index = 0; index < NumVertices; ++index) {
+		float const position = static_cast<float>(index) * 0.001f;
+		vertices.emplace_back(glm::vec3{ position, -position, 1.0f }, Color{ 255, 255, 255, 255 }, glm::vec3{ 0, 0, 1 }, glm::vec2{ position, 0.5f });
+	}
+
+	std::vector<std::byte> element_bytes;
+	Vertices_Simple element_vertices;
+	Milliseconds const element_write = Measure([&]() {
+		for (size_t pass = 0; pass < NumPasses; ++pass) {
+			element_bytes.clear();
+			Archive::Output archive{ element_bytes };
+			Archive::Serializer<size_t>::Write(archive, vertices.size());
+			for (Vertex_Simple const& vertex : vertices) Archive::Serializer<Vertex_Simple>::Write(archive, vertex);
+		}
+	});
+	Milliseconds const element_read = Measure([&]() {
+		for (size_t pass = 0; pass < NumPasses; ++pass) {
+			Archive::Input archive{ std::span<std::byte const>{ element_bytes } };
+			size_t num = 0;
+			Archive::Serializer<size_t>::Read(archive, num);
+			element_vertices.resize(num);
+			for (Vertex_Simple& vertex : element_vertices) Archive::Serializer<Vertex_Simple>::Read(archive, vertex);
+		}
+	});
+
+	std::vector<std::byte> bulk_bytes;
+	Vertices_Simple bulk_vertices;
+	Milliseconds const bulk_write = Measure([&]() {
+		for (size_t pass = 0; pass < NumPasses; ++pass) {
+			bulk_bytes.clear();
+			Archive::Output archive{ bulk_bytes };
+			archive << vertices;
+		}
+	});
+	Milliseconds const bulk_read = Measure([&]() {
+		for (size_t pass = 0; pass < NumPasses; ++pass) {
+			Archive::Input archive{ std::span<std::byte const>{ bulk_bytes } };
+			archive >> bulk_vertices;
+		}
+	});
+
+	std::span<std::byte const> const expected = std::as_bytes(std::span<Vertex_Simple const>{ vertices });
+	bool const matches = element_bytes == bulk_bytes
+		&& ranges::equal(std::as_bytes(std::span<Vertex_Simple const>{ element_vertices }), expected)
+		&& ranges::equal(std::as_bytes(std::span<Vertex_Simple const>{ bulk_vertices }), expected);
+
+	LOG(Benchmarks, Info, "Bulk arrays: one element at a time, wrote {} vertices in {:.2f} ms and read them in {:.2f} ms",
+		NumVertices, element_write.count() / NumPasses, element_read.count() / NumPasses);
+	LOG(Benchmarks, Info, "Bulk arrays: as a block, wrote {} vertices in {:.2f} ms and read them in {:.2f} ms ({} bytes, {})",
+		NumVertices, bulk_write.count() / NumPasses, bulk_read.count() / NumPasses, bulk_bytes.size(), matches ? "results match" : "RESULTS DIFFER");
+}
+
+int main(int argc, char** argv) {
+	//Allocate a temporary buffer for the main thread
+	ThreadBuffer buffer{ 20'000 };
+
+	Logger::Get().AddDevices(std::make_shared<TerminalLogDevice>());
+
+	LOG(Benchmarks, Info, "Running benchmarks compiled with {}", COMPILER_VERSION);
+
+	BenchmarkConcurrentIteration();
+	BenchmarkPooledAllocation();
+	BenchmarkDependencyGraph();
+	BenchmarkRequestPriorities();
+	BenchmarkCompression();
+	BenchmarkStructSerialization();
+	BenchmarkBulkArrays();
+
+	return 0;
+}
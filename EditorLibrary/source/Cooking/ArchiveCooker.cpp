@@ -0,0 +1,116 @@
+#include "Cooking/ArchiveCooker.h"
+#include "Engine/Map.h"
+#include "Engine/Set.h"
+#include "HAL/MappedFile.h"
+#include "Resources/PackageIO.h"
+
+namespace Cooking {
+	/** A package that was found in the directory being cooked */
+	struct PackageSourceFile {
+		Resources::EPackageSourceType source = Resources::EPackageSourceType::YAML;
+		std::filesystem::path path;
+		/** The dependencies of the package, sorted so the placement does not depend on the order of a hash table */
+		std::vector<StringID> dependencies;
+	};
+
+	/** Determines the order in which packages are placed within the archive */
+	struct ArchivePlacement {
+		std::unordered_map<StringID, PackageSourceFile> const& packages;
+		std::vector<StringID> order;
+		std::unordered_set<StringID> placed;
+		std::unordered_set<StringID> visiting;
+
+		/** Place a package after any of its dependencies that were not already placed */
+		void Place(StringID name) {
+			if (placed.contains(name)) return;
+
+			//Dependencies in other archives are not placed, and a dependency cycle is placed in the order it is found
+			auto const iter = packages.find(name);
+			if (iter == packages.end() || !visiting.insert(name).second) return;
+
+			for (StringID const dependency : iter->second.dependencies) Place(dependency);
+
+			visiting.erase(name);
+			placed.insert(name);
+			order.emplace_back(name);
+		}
+	};
+
+	static bool LessByName(StringID a, StringID b) {
+		return a.ToStringView() < b.ToStringView();
+	}
+
+	/** Find all packages in the directory, choosing the binary version of each package if it is up to date */
+	static std::unordered_map<StringID, PackageSourceFile> FindPackages(std::filesystem::path const& directory) {
+		std::unordered_map<StringID, PackageSourceFile> packages;
+
+		for (std::filesystem::directory_entry const& file : std::filesystem::recursive_directory_iterator{ directory }) {
+			if (!file.is_regular_file()) continue;
+
+			std::filesystem::path const& path = file.path();
+			bool const is_binary = path.extension() == ".bin"sv;
+			if (!is_binary && path.extension() != ".yaml"sv) continue;
+
+			StringID const name{ std::filesystem::path{ path.lexically_relative(directory) }.replace_extension().generic_string() };
+
+			//Packages are saved in the editable format, so a binary package that is older than the editable package is out of date
+			auto const iter = packages.find(name);
+			if (iter != packages.end()) {
+				bool const existing_is_binary = iter->second.source == Resources::EPackageSourceType::Binary;
+				std::filesystem::path const& binary_path = is_binary ? path : iter->second.path;
+				std::filesystem::path const& editable_path = is_binary ? iter->second.path : path;
+				if (std::filesystem::last_write_time(binary_path) < std::filesystem::last_write_time(editable_path)) {
+					if (existing_is_binary) iter->second = PackageSourceFile{ Resources::EPackageSourceType::YAML, path };
+				} else {
+					if (!existing_is_binary) iter->second = PackageSourceFile{ Resources::EPackageSourceType::Binary, path };
+				}
+			} else {
+				packages.emplace(name, PackageSourceFile{ is_binary ? Resources::EPackageSourceType::Binary : Resources::EPackageSourceType::YAML, path });
+			}
+		}
+
+		for (auto& [name, package] : packages) {
+			std::unordered_set<StringID> dependencies;
+			if (package.source == Resources::EPackageSourceType::Binary) {
+				dependencies = Resources::PackageInput_Binary{ package.path }.GetDependencies();
+			} else {
+				std::ifstream stream{ package.path, std::ios_base::in };
+				dependencies = Resources::PackageInput_YAML{ stream }.GetDependencies();
+			}
+
+			package.dependencies.assign(dependencies.begin(), dependencies.end());
+			std::sort(package.dependencies.begin(), package.dependencies.end(), &LessByName);
+		}
+
+		return packages;
+	}
+
+	size_t CookArchive(std::filesystem::path const& directory, std::filesystem::path const& output, ArchiveCookSettings const& settings) {
+		std::unordered_map<StringID, PackageSourceFile> const packages = FindPackages(directory);
+
+		ArchivePlacement placement{ packages };
+		placement.order.reserve(packages.size());
+
+		for (StringID const name : settings.order) {
+			if (!packages.contains(name)) throw FormatType<std::runtime_error>("Package {} was listed in the order of archive '{}', but was not found in directory '{}'", name, output.generic_string(), directory.generic_string());
+			placement.Place(name);
+		}
+
+		std::vector<StringID> remaining;
+		for (auto const& [name, package] : packages) {
+			if (!placement.placed.contains(name)) remaining.emplace_back(name);
+		}
+		std::sort(remaining.begin(), remaining.end(), &LessByName);
+		for (StringID const name : remaining) placement.Place(name);
+
+		Resources::PackageArchiveOutput archive{ output, settings.alignment };
+		for (StringID const name : placement.order) {
+			PackageSourceFile const& package = packages.at(name);
+			HAL::MappedFile const file{ package.path };
+			archive.Add(name, package.source, file.GetBytes());
+		}
+		archive.Finish();
+
+		return placement.order.size();
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "Engine/Core.h"
+#include "Engine/StringID.h"
+#include "Resources/PackageArchive.h"
+
+namespace Cooking {
+	/** Options for how packages are placed within a cooked archive */
+	struct ArchiveCookSettings {
+		/**
+		 * Packages that are placed first, in this order. Typically the packages that are loaded together, such as the packages for a level.
+		 * Each package is preceded by any of its dependencies that were not already placed, since they are loaded at the same time.
+		 * Packages that are not listed are placed afterwards, ordered by name.
+		 */
+		std::vector<StringID> order;
+		/** The alignment of each package within the archive */
+		size_t alignment = Resources::PackageArchiveOutput::DefaultAlignment;
+	};
+
+	/**
+	 * Build a package archive from all packages in a directory, replacing the archive if it already exists. Returns the number of packages in the archive.
+	 * Binary packages are used if they are up to date with the editable version of the package, otherwise the editable version is stored.
+	 */
+	size_t CookArchive(std::filesystem::path const& directory, std::filesystem::path const& output, ArchiveCookSettings const& settings = {});
+}
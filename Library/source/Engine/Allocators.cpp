@@ -0,0 +1,54 @@
+#include "Engine/Allocators.h"
+
+BlockPool::~BlockPool() {
+	size_t const alignment = block_alignment;
+	for (std::byte* slab : slabs) ::operator delete(slab, std::align_val_t{ alignment });
+}
+
+bool BlockPool::Fits(size_t size, size_t alignment) const noexcept {
+	return size > 0 && size <= block_size && alignment <= block_alignment;
+}
+
+void* BlockPool::Allocate(size_t size, size_t alignment) {
+	std::scoped_lock const lock{ mutex };
+
+	//The first allocation determines the size of all blocks. Blocks must also be large enough to hold a link to the next free block.
+	if (block_size == 0) {
+		size_t const minimum_alignment = std::max(alignment, alignof(FreeBlock));
+		block_alignment = minimum_alignment;
+		block_size = (std::max(size, sizeof(FreeBlock)) + minimum_alignment - 1) / minimum_alignment * minimum_alignment;
+	}
+
+	if (!Fits(size, alignment)) return nullptr;
+
+	if (!free_blocks) AllocateSlab();
+
+	FreeBlock* const block = free_blocks;
+	free_blocks = block->next;
+	++num_allocated_blocks;
+
+	block->~FreeBlock();
+	return block;
+}
+
+void BlockPool::Deallocate(void* block) noexcept {
+	std::scoped_lock const lock{ mutex };
+
+	//Recently freed blocks are reused first, since they are the most likely to still be in the cache
+	free_blocks = new (block) FreeBlock{ free_blocks };
+	--num_allocated_blocks;
+}
+
+void BlockPool::AllocateSlab() {
+	size_t const size = block_size;
+	size_t const alignment = block_alignment;
+
+	std::byte* const slab = static_cast<std::byte*>(::operator new(size * blocks_per_slab, std::align_val_t{ alignment }));
+	slabs.emplace_back(slab);
+	++num_slabs;
+
+	//Blocks are linked in reverse so that they are allocated in order of their address
+	for (size_t rnum = blocks_per_slab; rnum > 0; --rnum) {
+		free_blocks = new (slab + (rnum - 1) * size) FreeBlock{ free_blocks };
+	}
+}
@@ -1,6 +1,9 @@
 #pragma once
+#include "Engine/Array.h"
 #include "Engine/Buffers.h"
 #include "Engine/Core.h"
+#include "Engine/SmartPointers.h"
+#include "Engine/Threads.h"
 
 /** Allocator which holds space for a number of elements on the stack */
 template<typename T, size_t N>
@@ -84,3 +87,78 @@ private:
 	Buffer* buffer;
 	FallbackAllocatorType fallback;
 };
+
+/**
+ * A pool of fixed-size blocks of memory. Blocks are allocated in slabs, so blocks allocated around the same time are stored contiguously,
+ * and freed blocks are recycled by later allocations. The size of a block is determined by the first allocation. Safe to use from multiple threads.
+ */
+struct BlockPool {
+	BlockPool(size_t blocks_per_slab = 256) : blocks_per_slab(std::max<size_t>(blocks_per_slab, 1)) {}
+	BlockPool(BlockPool const&) = delete;
+	~BlockPool();
+
+	/** Returns true if an allocation with the size and alignment will use a block from this pool */
+	bool Fits(size_t size, size_t alignment) const noexcept;
+
+	/** Allocate a block for an allocation with the size and alignment. Returns nullptr if the allocation does not fit within a block. */
+	void* Allocate(size_t size, size_t alignment);
+	/** Return a block to the pool so it can be used by a later allocation */
+	void Deallocate(void* block) noexcept;
+
+	/** The number of blocks that are currently allocated */
+	inline size_t GetNumAllocatedBlocks() const noexcept { return num_allocated_blocks; }
+	/** The number of slabs that were allocated from the heap to create blocks */
+	inline size_t GetNumSlabs() const noexcept { return num_slabs; }
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	size_t const blocks_per_slab;
+	std::atomic<size_t> block_size = 0;
+	std::atomic<size_t> block_alignment = 0;
+
+	std::atomic<size_t> num_allocated_blocks = 0;
+	std::atomic<size_t> num_slabs = 0;
+
+	std::mutex mutex;
+	FreeBlock* free_blocks = nullptr;
+	std::vector<std::byte*> slabs;
+
+	/** Allocate a new slab and add its blocks to the free blocks. Must be called while the mutex is locked. */
+	void AllocateSlab();
+};
+
+/** Allocator that takes memory from a shared pool of blocks. Allocations that do not fit within a block use default allocation. */
+template<typename T>
+struct TPoolAllocator {
+public:
+	template<typename U> friend struct TPoolAllocator;
+
+	using value_type = T;
+
+	TPoolAllocator(std::shared_ptr<BlockPool> pool) noexcept : pool(std::move(pool)) {}
+
+	TPoolAllocator(TPoolAllocator const&) = default;
+	template<typename U> TPoolAllocator(TPoolAllocator<U> const& other) noexcept : pool(other.pool) {}
+	~TPoolAllocator() = default;
+
+	template<typename U> bool operator==(TPoolAllocator<U> const& other) const noexcept { return pool == other.pool; }
+	template<typename U> bool operator!=(TPoolAllocator<U> const& other) const noexcept { return !this->operator==(other); }
+
+	T* allocate(size_t count) {
+		if (void* const block = pool->Allocate(sizeof(T) * count, alignof(T))) return static_cast<T*>(block);
+		else return std::allocator<T>{}.allocate(count);
+	}
+
+	void deallocate(T* const pointer, size_t count) {
+		//Only return memory to the pool if it would have fit within a block. Otherwise, the default allocator was used to create it.
+		if (pool->Fits(sizeof(T) * count, alignof(T))) pool->Deallocate(pointer);
+		else std::allocator<T>{}.deallocate(pointer, count);
+	}
+
+private:
+	/** Shared by all copies of the allocator, which keeps the pool alive as long as any memory from it may still be in use */
+	std::shared_ptr<BlockPool> pool;
+};
@@ -22,3 +22,44 @@ void Archive::Skip(Input& archive, size_t num) {
 Archive::Input Archive::Subset(Input const& archive, size_t num) {
 	return Input{ archive.buffer.subspan(0, num) };
 }
+
+Archive::Section Archive::BeginSection(Output& archive) {
+	Section const section{ archive.buffer.size() };
+	//Reserve space for the size, which is not known until the section ends
+	archive.buffer.resize(section.position + sizeof(size_t));
+	return section;
+}
+
+size_t Archive::EndSection(Output& archive, Section section) {
+	size_t const size = archive.buffer.size() - (section.position + sizeof(size_t));
+
+	//Encode the size the same way it would be encoded by the size_t serializer, so sections can also be read as byte spans
+	size_t encoded = size;
+	if constexpr (std::endian::native != std::endian::little) encoded = std::byteswap(size);
+	std::memcpy(archive.buffer.data() + section.position, &encoded, sizeof(size_t));
+
+	return size;
+}
+
+void Archive::Rewind(Output& archive, size_t size) {
+	if (size < archive.buffer.size()) archive.buffer.resize(size);
+}
+
+std::span<std::byte const> Archive::GetSectionBytes(Output const& archive, Section section) {
+	return std::span<std::byte const>{ archive.buffer }.subspan(section.position + sizeof(size_t));
+}
+
+/** Read a section from the archive. Throws if the archive does not contain the entire section. */
+Archive::Input Archive::ReadSection(Input& archive) {
+	size_t size = 0;
+	archive >> size;
+	if (size > archive.Remaining()) throw std::runtime_error{ "Archive section is larger than the remaining bytes in the archive" };
+
+	Input const section = Subset(archive, size);
+	Skip(archive, size);
+	return section;
+}
+
+void Archive::SkipSection(Input& archive) {
+	ReadSection(archive);
+}
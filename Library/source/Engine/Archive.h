@@ -5,6 +5,11 @@
 #include "Engine/Core.h"
 
 namespace Archive {
+	/** A section of an output archive which is prefixed by its size. Space for the size is reserved when the section begins, and the size is written when it ends. */
+	struct Section {
+		size_t position = 0;
+	};
+
 	/** Wraps a dynamic array of bytes in memory, and allows new objects to be encoded and added to those bytes. Similar to an ostream, but much simpler. */
 	struct Output {
 		using BufferType = std::vector<std::byte>;
@@ -20,6 +25,10 @@ namespace Archive {
 
 	private:
 		friend void WriteBytes(Output&, std::span<std::byte const>);
+		friend Section BeginSection(Output&);
+		friend size_t EndSection(Output&, Section);
+		friend void Rewind(Output&, size_t);
+		friend std::span<std::byte const> GetSectionBytes(Output const&, Section);
 
 		BufferType& buffer;
 	};
@@ -43,4 +52,18 @@ namespace Archive {
 
 		std::span<std::byte const> buffer;
 	};
+
+	/** Begin a new section in the archive. Everything written until the section ends is included in the section. */
+	Section BeginSection(Output& archive);
+	/** End a section in the archive, writing the size of the section before its contents. Returns the size of the section. */
+	size_t EndSection(Output& archive, Section section);
+	/** Remove all bytes that were written to the archive after it had the provided size */
+	void Rewind(Output& archive, size_t size);
+	/** Get the contents of a section that has ended. The bytes are only valid until more bytes are written to the archive. */
+	std::span<std::byte const> GetSectionBytes(Output const& archive, Section section);
+
+	/** Read a section from the archive, returning a new archive that contains only the contents of the section. The section is skipped in the source archive. */
+	Input ReadSection(Input& archive);
+	/** Skip past a section in the archive without reading its contents */
+	void SkipSection(Input& archive);
 }
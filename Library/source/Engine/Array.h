@@ -38,27 +38,70 @@ namespace Archive {
 		};
 	}
 
+	/** Write the elements of a contiguous range as a single block of bytes */
+	template<Concepts::BulkSerializable T>
+	inline void WriteBulk(Output& archive, std::span<T const> elements) {
+		WriteBytes(archive, std::as_bytes(elements));
+	}
+
+	/** Returns false if values of the type are currently being read from data where they were not saved as their bytes in memory */
+	template<Concepts::BulkSerializable T>
+	inline bool CanReadBulk() {
+		if constexpr (std::floating_point<T>) return !LegacyFloatScope::IsEnabled();
+		else return true;
+	}
+
+	/** Read the elements of a contiguous range as a single block of bytes */
+	template<Concepts::BulkSerializable T>
+	inline void ReadBulk(Input& archive, std::span<T> elements) {
+		if (!CanReadBulk<T>()) {
+			for (T& element : elements) Serializer<T>::Read(archive, element);
+			return;
+		}
+
+		std::span<std::byte const> const bytes = ReadBytes(archive, elements.size_bytes());
+		std::memcpy(elements.data(), bytes.data(), bytes.size());
+	}
+
 	template<Concepts::ReadWritable T, size_t N>
 	struct Serializer<std::array<T, N>> {
 		static void Write(Output& archive, std::array<T, N> const& value) {
-			for (T const& element : value) Serializer<T>::Write(archive, element);
+			if constexpr (Concepts::BulkSerializable<T>) WriteBulk(archive, std::span<T const>{ value });
+			else for (T const& element : value) Serializer<T>::Write(archive, element);
 		}
 		static void Read(Input& archive, std::array<T, N>& value) {
-			for (T const& element : value) Serializer<T>::Read(archive, element);
+			if constexpr (Concepts::BulkSerializable<T>) ReadBulk(archive, std::span<T>{ value });
+			else for (T& element : value) Serializer<T>::Read(archive, element);
 		}
 	};
 
 	template<typename T, Concepts::ReadWritableRange<T> R>
 	struct DynamicArraySerializer {
+		/** Elements of contiguous ranges that are serialized as their bytes in memory are copied as a single block. The bytes are the same as writing each element separately. */
+		static constexpr bool IsBulk = Concepts::BulkSerializable<T> && ranges::contiguous_range<R> && Concepts::Resizeable<R>;
+
 		static void Write(Output& archive, R const& range) {
 			Serializer<size_t>::Write(archive, ranges::size(range));
-			for (T const& element : range) Serializer<T>::Write(archive, element);
+			if constexpr (IsBulk) WriteBulk(archive, std::span<T const>{ range });
+			else for (T const& element : range) Serializer<T>::Write(archive, element);
 		}
 
 		static void Read(Input& archive, R& range) {
 			size_t num = 0;
 			Serializer<size_t>::Read(archive, num);
 
+			if constexpr (IsBulk) {
+				if (CanReadBulk<T>()) {
+					//The number of elements is checked before resizing, so a corrupted count cannot cause a huge allocation
+					if (num > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::runtime_error{ "Array is too large to be read" };
+					std::span<std::byte const> const bytes = ReadBytes(archive, num * sizeof(T));
+
+					range.resize(num);
+					std::memcpy(ranges::data(range), bytes.data(), bytes.size());
+					return;
+				}
+			}
+
 			if constexpr (Concepts::Resizeable<R> && std::is_default_constructible_v<T>) {
 				range.resize(num);
 				for (T& element : range) Serializer<T>::Read(archive, element);
@@ -0,0 +1,191 @@
+#include "Engine/Compression.h"
+#include "Engine/Format.h"
+#include <cstring>
+
+namespace Compression {
+	/**
+	 * Compresses blocks using the LZ4 block format. Each sequence is a token, followed by literals copied directly to the output,
+	 * followed by a match that copies previous output. The compressor uses a single-probe hash table, favoring speed over ratio.
+	 */
+	struct LZ4BlockCodec : public ICodec {
+		virtual void Compress(std::span<std::byte const> source, std::vector<std::byte>& output) const override {
+			size_t const size = source.size();
+			size_t anchor = 0;
+
+			//The format requires the last sequence to contain only literals, so matches may not start within the final bytes of the block.
+			//Positions are stored as 32-bit values, so larger blocks are stored as literals.
+			if (size >= MinimumInputSize && size < InvalidPosition) {
+				size_t const match_limit = size - LastMatchDistance;
+				size_t const end_limit = size - LastLiteralsSize;
+
+				std::vector<uint32_t> table(size_t{ 1 } << HashBits, InvalidPosition);
+
+				size_t position = 0;
+				while (position < match_limit) {
+					uint32_t const sequence = Read32(source, position);
+					uint32_t& entry = table[Hash(sequence)];
+					size_t const candidate = entry;
+					entry = static_cast<uint32_t>(position);
+
+					if (candidate == InvalidPosition || position - candidate > MaxOffset || Read32(source, candidate) != sequence) {
+						++position;
+						continue;
+					}
+
+					size_t length = MinMatch;
+					while (position + length < end_limit && source[candidate + length] == source[position + length]) ++length;
+
+					WriteSequence(output, source.subspan(anchor, position - anchor), position - candidate, length);
+					position += length;
+					anchor = position;
+				}
+			}
+
+			WriteLastLiterals(output, source.subspan(anchor));
+		}
+
+		virtual void Decompress(std::span<std::byte const> source, std::span<std::byte> output) const override {
+			size_t input = 0;
+			size_t written = 0;
+
+			while (input < source.size()) {
+				uint8_t const token = static_cast<uint8_t>(source[input++]);
+
+				size_t const literals = ReadLength(source, input, token >> 4);
+				if (literals > source.size() - input || literals > output.size() - written) throw std::runtime_error{ "Compressed block literals are out of bounds" };
+				std::copy_n(source.begin() + input, literals, output.begin() + written);
+				input += literals;
+				written += literals;
+
+				//The last sequence has no match, and ends the block
+				if (input == source.size()) break;
+
+				if (source.size() - input < 2) throw std::runtime_error{ "Compressed block match offset is truncated" };
+				size_t const offset = static_cast<size_t>(source[input]) | (static_cast<size_t>(source[input + 1]) << 8);
+				input += 2;
+				if (offset == 0 || offset > written) throw std::runtime_error{ "Compressed block match offset is out of bounds" };
+
+				size_t const length = ReadLength(source, input, token & 0x0F) + MinMatch;
+				if (length > output.size() - written) throw std::runtime_error{ "Compressed block match length is out of bounds" };
+
+				//Matches may overlap the bytes they are writing, in which case they repeat a pattern. These must be copied one byte at a time.
+				if (offset >= length) {
+					std::copy_n(output.begin() + (written - offset), length, output.begin() + written);
+				} else {
+					for (size_t index = 0; index < length; ++index) output[written + index] = output[written + index - offset];
+				}
+				written += length;
+			}
+
+			if (written != output.size()) throw std::runtime_error{ "Compressed block does not match the expected size" };
+		}
+
+	private:
+		static constexpr size_t MinMatch = 4;
+		static constexpr size_t MaxOffset = 65535;
+		static constexpr size_t LastLiteralsSize = 5;
+		static constexpr size_t LastMatchDistance = 12;
+		static constexpr size_t MinimumInputSize = LastMatchDistance + 1;
+		static constexpr size_t HashBits = 16;
+		static constexpr uint32_t InvalidPosition = std::numeric_limits<uint32_t>::max();
+
+		static inline uint32_t Read32(std::span<std::byte const> source, size_t position) {
+			uint32_t value = 0;
+			std::memcpy(&value, source.data() + position, sizeof(value));
+			return value;
+		}
+
+		static inline size_t Hash(uint32_t sequence) {
+			return (sequence * 2654435761u) >> (32 - HashBits);
+		}
+
+		static void WriteLength(std::vector<std::byte>& output, size_t length) {
+			for (; length >= 255; length -= 255) output.emplace_back(std::byte{ 255 });
+			output.emplace_back(static_cast<std::byte>(length));
+		}
+
+		static size_t ReadLength(std::span<std::byte const> source, size_t& input, size_t length) {
+			if (length == 15) {
+				uint8_t next = 255;
+				while (next == 255) {
+					if (input >= source.size()) throw std::runtime_error{ "Compressed block length is truncated" };
+					next = static_cast<uint8_t>(source[input++]);
+					length += next;
+				}
+			}
+			return length;
+		}
+
+		static void WriteSequence(std::vector<std::byte>& output, std::span<std::byte const> literals, size_t offset, size_t length) {
+			size_t const match = length - MinMatch;
+			output.emplace_back(static_cast<std::byte>((std::min<size_t>(literals.size(), 15) << 4) | std::min<size_t>(match, 15)));
+
+			if (literals.size() >= 15) WriteLength(output, literals.size() - 15);
+			output.append_range(literals);
+
+			output.emplace_back(static_cast<std::byte>(offset & 0xFF));
+			output.emplace_back(static_cast<std::byte>(offset >> 8));
+
+			if (match >= 15) WriteLength(output, match - 15);
+		}
+
+		static void WriteLastLiterals(std::vector<std::byte>& output, std::span<std::byte const> literals) {
+			output.emplace_back(static_cast<std::byte>(std::min<size_t>(literals.size(), 15) << 4));
+			if (literals.size() >= 15) WriteLength(output, literals.size() - 15);
+			output.append_range(literals);
+		}
+	};
+
+	/** The codecs that are registered for each id. Lookups happen for every compressed resource, so they should not require a lock. */
+	struct CodecRegistry {
+		LZ4BlockCodec const block_codec{};
+		std::array<std::atomic<ICodec const*>, std::numeric_limits<CodecID>::max() + 1> codecs{};
+
+		CodecRegistry() {
+			codecs[BlockCodec] = &block_codec;
+		}
+	};
+
+	std::array<std::atomic<ICodec const*>, std::numeric_limits<CodecID>::max() + 1>& GetCodecs() {
+		static CodecRegistry registry;
+		return registry.codecs;
+	}
+
+	void RegisterCodec(CodecID id, ICodec const& codec) {
+		if (id == NoCodec) throw std::runtime_error{ "Cannot register a codec for data without compression" };
+		GetCodecs()[id] = &codec;
+	}
+
+	void UnregisterCodec(CodecID id) {
+		GetCodecs()[id] = nullptr;
+	}
+
+	ICodec const* FindCodec(CodecID id) {
+		return GetCodecs()[id].load();
+	}
+
+	CodecID Compress(CodecID id, std::span<std::byte const> source, std::vector<std::byte>& output) {
+		if (ICodec const* codec = FindCodec(id)) {
+			size_t const start = output.size();
+			codec->Compress(source, output);
+
+			if (output.size() - start < source.size()) return id;
+			output.resize(start);
+		}
+
+		output.append_range(source);
+		return NoCodec;
+	}
+
+	void Decompress(CodecID id, std::span<std::byte const> source, std::span<std::byte> output) {
+		if (id == NoCodec) {
+			if (source.size() != output.size()) throw std::runtime_error{ "Uncompressed data does not match the expected size" };
+			std::copy(source.begin(), source.end(), output.begin());
+			return;
+		}
+
+		ICodec const* codec = FindCodec(id);
+		if (!codec) throw FormatType<std::runtime_error>("No codec is registered with id {}, cannot decompress data", id);
+		codec->Decompress(source, output);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Engine/Array.h"
+#include "Engine/Core.h"
+
+namespace Compression {
+	/** Identifies a codec that was used to compress data. Stored alongside compressed data, so values must never be reused for a different codec. */
+	using CodecID = uint8_t;
+
+	/** Data that is stored without compression */
+	constexpr CodecID NoCodec = 0;
+	/** The built-in block codec, which uses the LZ4 block format. Fast to decompress, with a moderate compression ratio. */
+	constexpr CodecID BlockCodec = 1;
+	/** The first id that can be used for codecs that are registered outside of the engine */
+	constexpr CodecID FirstCustomCodec = 128;
+
+	/** Compresses and decompresses individual blocks of data. Codecs must be safe to use from multiple threads at the same time. */
+	struct ICodec {
+		virtual ~ICodec() = default;
+
+		/** Compress the source and append the compressed bytes to the output */
+		virtual void Compress(std::span<std::byte const> source, std::vector<std::byte>& output) const = 0;
+		/** Decompress the source into the output, which must be exactly the size of the uncompressed data. Throws if the source is malformed. */
+		virtual void Decompress(std::span<std::byte const> source, std::span<std::byte> output) const = 0;
+	};
+
+	/** Register a codec so it can be used to compress or decompress data. The codec must remain valid until it is unregistered. */
+	void RegisterCodec(CodecID id, ICodec const& codec);
+	/** Unregister a codec that was previously registered with the id */
+	void UnregisterCodec(CodecID id);
+	/** Find the codec registered with the id. Returns nullptr for NoCodec, or if no codec is registered. */
+	ICodec const* FindCodec(CodecID id);
+
+	/**
+	 * Compress the source with the codec and append the result to the output. Returns the codec that was actually used.
+	 * If the codec cannot reduce the size of the source, the source is appended without compression and NoCodec is returned.
+	 */
+	CodecID Compress(CodecID id, std::span<std::byte const> source, std::vector<std::byte>& output);
+	/** Decompress the source into the output using the codec. Throws if the codec is not registered, or if the source is malformed. */
+	void Decompress(CodecID id, std::span<std::byte const> source, std::span<std::byte> output);
+}
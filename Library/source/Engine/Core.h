@@ -3,12 +3,14 @@
 #pragma region STL
 #include <cassert>
 //Integer types
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 //Mathematical
 #include <algorithm>
 #include <limits>
 #include <numbers>
+#include <numeric>
 //Streams
 #include <fstream>
 #include <iomanip>
@@ -59,7 +61,8 @@ constexpr inline uint64_t hash_combine(uint64_t a, uint64_t b) { return a ^ (b +
 /** Extract the raw bytes from a stream. Does not limit the number of bytes that will be read, should not be used on infinite streams. */
 template<std::output_iterator<std::byte> OutputIterator>
 inline void ExtractBytes(std::istream& stream, OutputIterator output_iterator) {
-	for (auto iter = std::istream_iterator<char>{ stream }; iter != std::default_sentinel; ++iter) {
+	//Read from the stream buffer directly, since the formatted input of istream_iterator would skip whitespace bytes
+	for (auto iter = std::istreambuf_iterator<char>{ stream }; iter != std::default_sentinel; ++iter) {
 		*output_iterator = std::byte{ static_cast<unsigned char>(*iter) };
 		++output_iterator;
 	}
@@ -127,6 +130,21 @@ namespace Archive {
 		concept ReadWritable = Writable<T> and Readable<T>;
 	}
 
+	/**
+	 * True for types whose serialized form is exactly their bytes in memory, which allows contiguous ranges of them to be copied as a single block.
+	 * Can be specialized for other trivially copyable types that have no padding and whose serializer writes their bytes directly.
+	 */
+	template<typename T>
+	constexpr bool EnableBulkSerialization =
+		std::endian::native == std::endian::little and
+		((std::integral<T> and !std::same_as<T, bool>) or (std::floating_point<T> and std::numeric_limits<T>::is_iec559) or std::same_as<T, std::byte>);
+
+	namespace Concepts {
+		/** A type that can be read and written as its bytes in memory */
+		template<typename T>
+		concept BulkSerializable = ReadWritable<T> and std::is_trivially_copyable_v<T> and EnableBulkSerialization<std::remove_cv_t<T>>;
+	}
+
 	//=============================================================================
 	// Basic serialization support
 
@@ -158,6 +176,21 @@ namespace Archive {
 		}
 	};
 
+	/**
+	 * While this scope exists, floating-point values are read the way they were written before they were stored as their bits, which was converted to an integer.
+	 * Used to read data that was saved in that format, such as binary packages with an earlier version. Applies to reads on the current thread.
+	 */
+	struct LegacyFloatScope {
+		LegacyFloatScope(bool enabled) : previous(std::exchange(is_enabled, enabled)) {}
+		~LegacyFloatScope() { is_enabled = previous; }
+
+		static bool IsEnabled() { return is_enabled; }
+
+	private:
+		bool previous;
+		inline static thread_local bool is_enabled = false;
+	};
+
 	/** Serializer for floating-point types */
 	template<std::floating_point T>
 	struct Serializer<T> {
@@ -165,7 +198,7 @@ namespace Archive {
 		static constexpr size_t NumBytes = sizeof(T);
 
 		static void Write(Output& archive, T const value) {
-			IntegerType const integer_value = static_cast<IntegerType>(value);
+			IntegerType const integer_value = std::bit_cast<IntegerType>(value);
 			if constexpr (std::endian::native == std::endian::little) {
 				WriteBytes(archive, std::as_bytes(MakeSpan(integer_value)));
 			} else {
@@ -186,7 +219,9 @@ namespace Archive {
 				std::memcpy(&integer_value, span.data(), NumBytes);
 				std::byteswap(integer_value);
 			}
-			value = static_cast<T>(integer_value);
+
+			if (LegacyFloatScope::IsEnabled()) value = static_cast<T>(integer_value);
+			else value = std::bit_cast<T>(integer_value);
 		}
 	};
 
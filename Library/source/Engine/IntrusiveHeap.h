@@ -0,0 +1,98 @@
+#pragma once
+#include "Engine/Array.h"
+#include "Engine/Core.h"
+
+/**
+ * A binary max-heap of pointers to elements, where each element stores its own position within the heap.
+ * Because the position is known, elements can be removed or have their priority changed in place in logarithmic time.
+ * An element may only be contained in one heap that uses the same position member at a time.
+ */
+template<typename ElementType, typename PriorityProjection, size_t ElementType::* Position>
+struct IntrusiveHeap {
+public:
+	/** The position of an element which is not contained in any heap */
+	static constexpr size_t InvalidPosition = std::numeric_limits<size_t>::max();
+
+	inline bool empty() const { return elements.empty(); }
+	inline size_t size() const { return elements.size(); }
+
+	/** True if the element is contained in this heap */
+	inline bool Contains(ElementType const& element) const {
+		size_t const position = element.*Position;
+		return position < elements.size() && elements[position] == &element;
+	}
+
+	/** Get the element with the highest priority. The heap must not be empty. */
+	inline ElementType& Top() const { return *elements.front(); }
+
+	/** Add an element to the heap. The element must not already be contained in a heap. */
+	void Push(ElementType& element) {
+		elements.emplace_back(&element);
+		element.*Position = elements.size() - 1;
+		SiftUp(elements.size() - 1);
+	}
+
+	/** Remove and return the element with the highest priority. The heap must not be empty. */
+	ElementType& Pop() {
+		ElementType& top = *elements.front();
+		Remove(top);
+		return top;
+	}
+
+	/** Remove an element from the heap. Does nothing if the element is not contained in this heap. */
+	void Remove(ElementType& element) {
+		if (!Contains(element)) return;
+
+		size_t const position = element.*Position;
+		Swap(position, elements.size() - 1);
+		elements.pop_back();
+		element.*Position = InvalidPosition;
+
+		if (position < elements.size()) Update(position);
+	}
+
+	/** Restore the heap order after the priority of an element has changed. Does nothing if the element is not contained in this heap. */
+	void Update(ElementType const& element) {
+		if (Contains(element)) Update(element.*Position);
+	}
+
+private:
+	std::vector<ElementType*> elements;
+
+	static inline auto GetPriority(ElementType const* element) { return std::invoke(PriorityProjection{}, *element); }
+
+	inline void Swap(size_t a, size_t b) {
+		std::swap(elements[a], elements[b]);
+		elements[a]->*Position = a;
+		elements[b]->*Position = b;
+	}
+
+	inline void Update(size_t position) {
+		if (position > 0 && GetPriority(elements[position]) > GetPriority(elements[(position - 1) / 2])) SiftUp(position);
+		else SiftDown(position);
+	}
+
+	void SiftUp(size_t position) {
+		while (position > 0) {
+			size_t const parent = (position - 1) / 2;
+			if (!(GetPriority(elements[position]) > GetPriority(elements[parent]))) break;
+			Swap(position, parent);
+			position = parent;
+		}
+	}
+
+	void SiftDown(size_t position) {
+		while (true) {
+			size_t const left = position * 2 + 1;
+			size_t const right = left + 1;
+			size_t highest = position;
+
+			if (left < elements.size() && GetPriority(elements[left]) > GetPriority(elements[highest])) highest = left;
+			if (right < elements.size() && GetPriority(elements[right]) > GetPriority(elements[highest])) highest = right;
+			if (highest == position) break;
+
+			Swap(position, highest);
+			position = highest;
+		}
+	}
+};
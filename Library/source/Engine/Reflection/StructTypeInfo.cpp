@@ -1,174 +1,260 @@
 #include "Engine/Reflection/StructTypeInfo.h"
 #include "Engine/Archive.h"
 #include "Engine/Array.h"
+#include "Engine/Format.h"
 #include "Engine/Ranges.h"
 #include "Engine/String.h"
 #include "Engine/StringConversion.h"
 
 namespace Reflection {
-	static void SerializeVariables_Diff(StructTypeInfo const& type, YAML::Node& node, void const* instance, void const* defaults);
-	static void SerializeVariables_NonDiff(StructTypeInfo const& type, YAML::Node& node, void const* instance);
+	/**
+	 * Written at the start of a struct whose variables are identified by id. Structs that were saved before this identify variables by name,
+	 * and start with the length of the first name instead. No name is long enough to be mistaken for the marker.
+	 */
+	constexpr size_t IdentifiedVariablesMarker = std::numeric_limits<size_t>::max();
 
-	static void SerializeVariables_Diff(StructTypeInfo const& type, Archive::Output& archive, void const* instance, void const* defaults);
-	static void SerializeVariables_NonDiff(StructTypeInfo const& type, Archive::Output& archive, void const* instance);
+	StructSerializationPlan::StructSerializationPlan(StructTypeInfo const& type) {
+		void const* const defaults = type.GetDefaults();
+		bool const skip_defaults = defaults && type.flags.Has(ETypeFlags::EqualityComparable);
 
-	void StructSerializationHelpers::SerializeVariables(StructTypeInfo const& type, Archive::Output& archive, void const* instance) {
-		void const* defaults = type.GetDefaults();
-		if (defaults && type.flags.Has(ETypeFlags::EqualityComparable)) {
-			SerializeVariables_Diff(type, archive, instance, defaults);
-		} else {
-			SerializeVariables_NonDiff(type, archive, instance);
-		}
-	}
+		for (StructTypeInfo const* current = &type; current; current = current->base) {
+			for (std::unique_ptr<VariableInfo const> const& variable : current->GetVariables()) {
+				Step& step = steps.emplace_back();
+				step.variable = variable.get();
+				step.type = variable->type;
+				step.serialized = !variable->flags.Has(EVariableFlags::Deprecated);
 
-	void StructSerializationHelpers::DeserializeVariables(StructTypeInfo const& type, Archive::Input& archive, void* instance) {
-		std::u16string name;
-		std::span<std::byte const> buffer;
+				if (defaults) {
+					//Variables that are not stored within the instance, such as static variables, must always be accessed through the variable info
+					uintptr_t const begin = reinterpret_cast<uintptr_t>(defaults);
+					uintptr_t const address = reinterpret_cast<uintptr_t>(variable->GetImmutable(defaults));
+					if (address >= begin && address - begin + variable->type->memory.size <= type.memory.size) {
+						step.offset = address - begin;
+						//Only the address is requested, the defaults are never modified
+						step.is_mutable = variable->GetMutable(const_cast<void*>(defaults)) != nullptr;
+					}
+				}
 
-		const auto FindVariable = [&](std::u16string_view name) -> Reflection::VariableInfo const* {
-			for (StructTypeInfo const* current = &type; current; current = current->base) {
-				auto const iter = ranges::find_if(current->GetVariables(), [name](std::unique_ptr<VariableInfo const> const& info) { return info->name == name; });
-				if (iter != current->GetVariables().end()) return iter->get();
+				if (skip_defaults) step.defaults = variable->GetImmutable(defaults);
+
+				ConvertString(variable->name, step.u8name);
 			}
-			return nullptr;
-		};
+		}
 
-		while (true) {
-			//First read the information from the archive, then interpret it. This ensures we read all the information that was originally written.
-			archive >> name;
-			archive >> buffer;
+		ids.reserve(steps.size());
+		for (size_t index = 0; index < steps.size(); ++index) ids.emplace_back(steps[index].variable->id.ToValue(), index);
+		//Stable sorting keeps variables of derived types before variables of base types with the same id
+		std::stable_sort(ids.begin(), ids.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+	}
 
-			//If this is the sentinel value that indicates the end of the variables, then we can stop reading
-			if (name.size() == 0 || buffer.size() == 0) break;
+	StructSerializationPlan::Step const* StructSerializationPlan::Find(Hash32 id) const {
+		auto const iter = ranges::lower_bound(ids, id.ToValue(), std::less<uint32_t>{}, [](auto const& pair) { return pair.first; });
+		if (iter != ids.end() && iter->first == id.ToValue()) return &steps[iter->second];
+		else return nullptr;
+	}
 
-			if (VariableInfo const* const variable = FindVariable(name)) {
-				if (void* pointer = variable->GetMutable(instance)) {
-					Archive::Input subarchive{ buffer };
-					variable->type->Deserialize(subarchive, pointer);
-				}
-			}
-		}
+	StructSerializationPlan::Step const* StructSerializationPlan::Find(std::u16string_view name) const {
+		auto const iter = ranges::find_if(steps, [name](Step const& step) { return step.variable->name == name; });
+		if (iter != steps.end()) return &*iter;
+		else return nullptr;
 	}
 
-	void StructSerializationHelpers::SerializeVariables(StructTypeInfo const& type, YAML::Node& node, void const* instance) {
-		void const* defaults = type.GetDefaults();
-		if (defaults && type.flags.Has(ETypeFlags::EqualityComparable)) {
-			SerializeVariables_Diff(type, node, instance, defaults);
-		} else {
-			SerializeVariables_NonDiff(type, node, instance);
+	StructSerializationPlan const& StructTypeInfo::GetSerializationPlan() const {
+		std::call_once(plan_flag, [this]() { plan = std::make_unique<StructSerializationPlan const>(*this); });
+		return *plan;
+	}
+
+	void StructSerializationHelpers::SerializeVariables(StructTypeInfo const& type, Archive::Output& archive, void const* instance) {
+		archive << IdentifiedVariablesMarker;
+
+		//Serialize each variable as an id-section pair
+		for (StructSerializationPlan::Step const& step : type.GetSerializationPlan().steps) {
+			if (!step.serialized) continue;
+
+			void const* const value = step.GetImmutable(instance);
+			if (step.defaults && step.type->Equal(value, step.defaults)) continue;
+
+			size_t const start = archive.Size();
+			archive << step.variable->id;
+
+			Archive::Section const section = Archive::BeginSection(archive);
+			step.type->Serialize(archive, value);
+
+			//If no data was actually serialized for this variable, then remove it from the output.
+			if (Archive::EndSection(archive, section) == 0) Archive::Rewind(archive, start);
 		}
+
+		//Serialize an empty section as a sentinel value to indicate the end of the variables. Sections for variables are never empty.
+		archive << Hash32{};
+		Archive::EndSection(archive, Archive::BeginSection(archive));
 	}
 
-	void StructSerializationHelpers::DeserializeVariables(StructTypeInfo const& type, YAML::Node const& node, void* instance) {
-		const auto FindVariable = [&](std::u16string_view name) -> Reflection::VariableInfo const* {
-			for (StructTypeInfo const* current = &type; current; current = current->base) {
-				auto const iter = ranges::find_if(current->GetVariables(), [name](std::unique_ptr<VariableInfo const> const& info) { return info->name == name; });
-				if (iter != current->GetVariables().end()) return iter->get();
-			}
-			return nullptr;
-		};
+	void StructSerializationHelpers::DeserializeVariables(StructTypeInfo const& type, Archive::Input& archive, void* instance) {
+		StructSerializationPlan const& plan = type.GetSerializationPlan();
 
-		std::u16string u16name;
+		size_t marker = 0;
+		archive >> marker;
 
-		for (YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
-			std::string_view const name = it->first.as<std::string_view>();
+		if (marker == IdentifiedVariablesMarker) {
+			Hash32 id;
+			while (true) {
+				//First read the information from the archive, then interpret it. This ensures we read all the information that was originally written.
+				archive >> id;
+				Archive::Input subarchive = Archive::ReadSection(archive);
 
-			u16name.clear();
-			ConvertString(name, u16name);
+				//If this is the sentinel value that indicates the end of the variables, then we can stop reading
+				if (subarchive.Remaining() == 0) break;
 
-			if (Reflection::VariableInfo const* variable = FindVariable(u16name)) {
-				if (void* pointer = variable->GetMutable(instance)) {
-					variable->type->Deserialize(it->second, pointer);
+				//Variables that cannot be found are skipped, since the section has already been read
+				if (StructSerializationPlan::Step const* const step = plan.Find(id)) {
+					if (void* pointer = step->GetMutable(instance)) {
+						step->type->Deserialize(subarchive, pointer);
+					}
 				}
 			}
-		}
-	}
 
-	void SerializeVariables_Diff(StructTypeInfo const& type, YAML::Node& node, void const* instance, void const* defaults) {
-		std::string u8name;
+		} else {
+			//Data saved before variables were identified by id starts with the length of the first variable name instead of the marker
+			std::u16string name;
+			size_t length = marker;
 
-		for (StructTypeInfo const* current = &type; current; current = current->base) {
-			for (std::unique_ptr<VariableInfo const> const& variable : current->GetVariables()) {
-				if (!variable->flags.Has(Reflection::EVariableFlags::Deprecated) && !variable->type->Equal(variable->GetImmutable(instance), variable->GetImmutable(defaults))) {
-					YAML::Node const value = variable->type->Serialize(variable->GetImmutable(instance));
-
-					//If we've serialized any contents for this node, add it to the map using the name of the variable.
-					if (value) {
-						u8name.clear();
-						ConvertString(variable->name, u8name);
-						node[u8name] = value;
+			while (true) {
+				if (length > archive.Remaining() / sizeof(char16_t)) throw std::runtime_error{ "Variable name is longer than the remaining data" };
+				name.resize(length);
+				for (char16_t& character : name) archive >> character;
+				Archive::Input subarchive = Archive::ReadSection(archive);
+
+				if (name.size() == 0 || subarchive.Remaining() == 0) break;
+
+				if (StructSerializationPlan::Step const* const step = plan.Find(name)) {
+					if (void* pointer = step->GetMutable(instance)) {
+						step->type->Deserialize(subarchive, pointer);
 					}
 				}
+
+				archive >> length;
 			}
 		}
 	}
-	void SerializeVariables_NonDiff(StructTypeInfo const& type, YAML::Node& node, void const* instance) {
-		std::string u8name;
 
-		for (StructTypeInfo const* current = &type; current; current = current->base) {
-			for (std::unique_ptr<VariableInfo const> const& variable : current->GetVariables()) {
-				if (!variable->flags.Has(Reflection::EVariableFlags::Deprecated)) {
-					YAML::Node const value = variable->type->Serialize(variable->GetImmutable(instance));
-
-					//If we've serialized any contents for this node, add it to the map using the name of the variable.
-					if (value) {
-						u8name.clear();
-						ConvertString(variable->name, u8name);
-						node[u8name] = value;
-					}
-				}
+	/** Assign a default-constructed value to a variable. Does nothing if the type cannot be default-constructed and copied. */
+	static void ResetValue(TypeInfo const& type, void* pointer) {
+		if (!type.flags.Has(ETypeFlags::DefaultConstructable) || !type.flags.Has(ETypeFlags::CopyAssignable)) return;
+
+		std::unique_ptr<std::byte[]> const value = type.AllocateUninitialized();
+		type.Construct(value.get());
+		type.Copy(pointer, value.get());
+		type.Destruct(value.get());
+	}
+
+	void StructSerializationHelpers::ResetVariables(StructTypeInfo const& type, void* instance) {
+		void const* const defaults = type.GetDefaults();
+
+		for (StructSerializationPlan::Step const& step : type.GetSerializationPlan().steps) {
+			//Static variables do not belong to the instance, so they are not reset
+			if (step.variable->flags.Has(EVariableFlags::Static) || !step.type->flags.Has(ETypeFlags::CopyAssignable)) continue;
+
+			void* const pointer = step.GetMutable(instance);
+			if (!pointer) continue;
+
+			//Types that cannot be default-constructed, such as resources, reset each variable to the default value of the variable type instead
+			if (defaults) step.type->Copy(pointer, step.variable->GetImmutable(defaults));
+			else ResetValue(*step.type, pointer);
+		}
+	}
+
+	void StructSerializationHelpers::SerializeDelta(StructTypeInfo const& type, Archive::Output& archive, void const* instance, void const* base) {
+		archive << type.id << IdentifiedVariablesMarker;
+
+		std::vector<std::byte> base_bytes;
+
+		for (StructSerializationPlan::Step const& step : type.GetSerializationPlan().steps) {
+			if (!step.serialized) continue;
+
+			void const* const value = step.GetImmutable(instance);
+			void const* const base_value = step.GetImmutable(base);
+
+			bool const comparable = step.type->flags.Has(ETypeFlags::EqualityComparable);
+			if (comparable && step.type->Equal(value, base_value)) continue;
+
+			size_t const start = archive.Size();
+			archive << step.variable->id;
+
+			Archive::Section const section = Archive::BeginSection(archive);
+			step.type->Serialize(archive, value);
+
+			//Variables without any serialized data cannot be written, since an empty section ends the variables
+			bool unchanged = Archive::EndSection(archive, section) == 0;
+
+			//Types that cannot be compared directly are compared by their serialized bytes
+			if (!unchanged && !comparable) {
+				base_bytes.clear();
+				Archive::Output base_archive{ base_bytes };
+				step.type->Serialize(base_archive, base_value);
+				unchanged = ranges::equal(Archive::GetSectionBytes(archive, section), base_bytes);
 			}
+
+			if (unchanged) Archive::Rewind(archive, start);
 		}
+
+		archive << Hash32{};
+		Archive::EndSection(archive, Archive::BeginSection(archive));
 	}
 
-	void SerializeVariables_Diff(StructTypeInfo const& type, Archive::Output& archive, void const* instance, void const* defaults) {
-		std::vector<std::byte> buffer;
+	void StructSerializationHelpers::DeserializeDelta(StructTypeInfo const& type, Archive::Input& archive, void* instance) {
+		Hash128 id;
+		size_t marker = 0;
+		archive >> id >> marker;
+		if (id != type.id || marker != IdentifiedVariablesMarker) throw FormatType<std::runtime_error>("Patch was not created for type {}, it cannot be applied", type.name);
 
-		//Serialize each variable as a name-buffer pair
-		for (StructTypeInfo const* current = &type; current; current = current->base) {
-			for (std::unique_ptr<VariableInfo const> const& variable : current->GetVariables()) {
-				if (!variable->flags.Has(Reflection::EVariableFlags::Deprecated) && !variable->type->Equal(variable->GetImmutable(instance), variable->GetImmutable(defaults))) {
-					Archive::Output subarchive{ buffer };
-					variable->type->Serialize(subarchive, variable->GetImmutable(instance));
+		StructSerializationPlan const& plan = type.GetSerializationPlan();
 
-					//If data was actually serialized for this variable, then write it to the output.
-					if (buffer.size() > 0) {
-						archive << type.name;
-						archive << buffer;
+		Hash32 variable_id;
+		while (true) {
+			archive >> variable_id;
+			Archive::Input subarchive = Archive::ReadSection(archive);
+			if (subarchive.Remaining() == 0) break;
 
-						buffer.clear();
-					}
+			if (StructSerializationPlan::Step const* const step = plan.Find(variable_id)) {
+				if (void* pointer = step->GetMutable(instance)) {
+					//Values are serialized without the parts that match the defaults for their type, such as the variables of nested structs.
+					//The value from the base is reset first, so those parts are restored to the defaults instead of keeping the value from the base.
+					ResetValue(*step->type, pointer);
+					step->type->Deserialize(subarchive, pointer);
 				}
 			}
 		}
+	}
+
+	void StructSerializationHelpers::SerializeVariables(StructTypeInfo const& type, YAML::Node& node, void const* instance) {
+		for (StructSerializationPlan::Step const& step : type.GetSerializationPlan().steps) {
+			if (!step.serialized) continue;
+
+			void const* const value = step.GetImmutable(instance);
+			if (step.defaults && step.type->Equal(value, step.defaults)) continue;
 
-		//Serialize an "empty" variable as a sentinel value to indicate the end of the variables.
-		archive << ""sv;
-		archive << buffer;
+			//If we've serialized any contents for this node, add it to the map using the name of the variable.
+			if (YAML::Node const serialized = step.type->Serialize(value)) node[step.u8name] = serialized;
+		}
 	}
-	void SerializeVariables_NonDiff(StructTypeInfo const& type, Archive::Output& archive, void const* instance) {
-		std::vector<std::byte> buffer;
 
-		//Serialize each variable as a name-buffer pair
-		for (StructTypeInfo const* current = &type; current; current = current->base) {
-			for (std::unique_ptr<VariableInfo const> const& variable : current->GetVariables()) {
-				if (!variable->flags.Has(Reflection::EVariableFlags::Deprecated)) {
-					Archive::Output subarchive{ buffer };
-					variable->type->Serialize(subarchive, variable->GetImmutable(instance));
+	void StructSerializationHelpers::DeserializeVariables(StructTypeInfo const& type, YAML::Node const& node, void* instance) {
+		StructSerializationPlan const& plan = type.GetSerializationPlan();
+
+		const auto FindStep = [&](std::string_view name) -> StructSerializationPlan::Step const* {
+			auto const iter = ranges::find_if(plan.steps, [name](StructSerializationPlan::Step const& step) { return step.u8name == name; });
+			if (iter != plan.steps.end()) return &*iter;
+			else return nullptr;
+		};
 
-					//If data was actually serialized for this variable, then write it to the output.
-					if (buffer.size() > 0) {
-						archive << type.name;
-						archive << buffer;
+		for (YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+			std::string_view const name = it->first.as<std::string_view>();
 
-						buffer.clear();
-					}
+			if (StructSerializationPlan::Step const* const step = FindStep(name)) {
+				if (void* pointer = step->GetMutable(instance)) {
+					step->type->Deserialize(it->second, pointer);
 				}
 			}
 		}
-
-		//Serialize an "empty" variable as a sentinel value to indicate the end of the variables.
-		archive << ""sv;
-		archive << buffer;
 	}
 }
@@ -145,6 +145,20 @@ namespace Reflection {
 
 		void SerializeVariables(StructTypeInfo const& type, Archive::Output& archive, void const* instance);
 		void DeserializeVariables(StructTypeInfo const& type, Archive::Input& archive, void* instance);
+
+		/** Assign the default value to each variable of an instance, so deserializing data that omits a variable does not keep the previous value of that variable. */
+		void ResetVariables(StructTypeInfo const& type, void* instance);
+
+		/**
+		 * Write a patch that contains only the variables of the instance that differ from the base, such as the defaults for the type or a previously saved version of the instance.
+		 * The base must be an instance of the same type. Variables are compared for equality when possible, otherwise they are compared by their serialized bytes.
+		 */
+		void SerializeDelta(StructTypeInfo const& type, Archive::Output& archive, void const* instance, void const* base);
+		/**
+		 * Apply a patch to an instance that matches the base the patch was created from. Variables that are not in the patch are left unchanged, and variables in the patch are reset
+		 * before they are read, so parts of a value that were omitted because they match their defaults do not keep the value from the base. Throws if the patch was created for a different type.
+		 */
+		void DeserializeDelta(StructTypeInfo const& type, Archive::Input& archive, void* instance);
 	}
 }
 
@@ -1,4 +1,7 @@
 #pragma once
+#include <mutex>
+#include <string>
+#include <vector>
 #include "Engine/Concepts.h"
 #include "Engine/Core.h"
 #include "Engine/Flags.h"
@@ -329,6 +332,53 @@ namespace Reflection {
 		{}
 	};
 
+	/**
+	 * The variables of a struct flattened across all of its base types, with everything that does not depend on a particular instance resolved ahead of time.
+	 * Built once for each struct type, then used to serialize and deserialize every instance of that type.
+	 */
+	struct StructSerializationPlan {
+		static constexpr size_t InvalidOffset = std::numeric_limits<size_t>::max();
+
+		struct Step {
+			VariableInfo const* variable = nullptr;
+			TypeInfo const* type = nullptr;
+			/** The offset of the variable from the start of an instance. Variables without an offset are accessed through the variable info. */
+			size_t offset = InvalidOffset;
+			/** The value of the variable in the default instance, which is compared to skip unchanged variables. Null if unchanged variables are not skipped. */
+			void const* defaults = nullptr;
+			/** True if new values of this variable are saved */
+			bool serialized = false;
+			/** True if the variable can be modified when it is accessed by offset */
+			bool is_mutable = false;
+			/** The name of the variable in UTF-8, used as the key in YAML */
+			std::string u8name;
+
+			inline void const* GetImmutable(void const* instance) const {
+				if (offset != InvalidOffset) return static_cast<std::byte const*>(instance) + offset;
+				else return variable->GetImmutable(instance);
+			}
+			inline void* GetMutable(void* instance) const {
+				if (offset == InvalidOffset) return variable->GetMutable(instance);
+				else if (is_mutable) return static_cast<std::byte*>(instance) + offset;
+				else return nullptr;
+			}
+		};
+
+		/** The variables of the struct followed by the variables of each base type, in the order they are serialized */
+		std::vector<Step> steps;
+
+		StructSerializationPlan(StructTypeInfo const& type);
+
+		/** Find the step for the variable with the id. If a base type has a variable with the same id, the variable of the derived type is found. */
+		Step const* Find(Hash32 id) const;
+		/** Find the step for the variable with the name. Slower than finding by id, only used for data that was saved before variables were identified by id. */
+		Step const* Find(std::u16string_view name) const;
+
+	private:
+		/** The id of each variable and the index of its step, sorted by id */
+		std::vector<std::pair<uint32_t, size_t>> ids;
+	};
+
 	/** Info for a struct type, which contains various fields and supports inheritance */
 	struct StructTypeInfo : public TypeInfo {
 		static constexpr ETypeClassification Classification = ETypeClassification::Struct;
@@ -362,11 +412,18 @@ namespace Reflection {
 		/** Returns the known specific type of an instance deriving from this type, to our best determination. If this cannot be determined, this method will return the same type. */
 		virtual StructTypeInfo const& GetInstanceTypeInfo(void const* instance) const = 0;
 
+		/** Get the plan used to serialize instances of this struct. The plan is built the first time it is requested, and may be requested from multiple threads. */
+		StructSerializationPlan const& GetSerializationPlan() const;
+
 	protected:
 		template<typename T>
 		StructTypeInfo(std::in_place_type_t<T> t, Hash128 id, std::u16string_view name, std::u16string_view description) : TypeInfo(Classification, t, id, name, description) {}
 
 		virtual void* AllocateRaw() const = 0;
+
+	private:
+		mutable std::once_flag plan_flag;
+		mutable std::unique_ptr<StructSerializationPlan const> plan;
 	};
 
 	/** TypeInfo for an enum, which is a type that can be set equal to one of several discrete named values */
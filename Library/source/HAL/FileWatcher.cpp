@@ -0,0 +1,139 @@
+#include "HAL/FileWatcher.h"
+#include "Engine/Format.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace HAL {
+#if defined(__linux__)
+	FileWatcher::FileWatcher(std::filesystem::path const& directory, CallbackType callback)
+		: directory(directory), callback(callback)
+	{
+		descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (descriptor < 0) throw FormatType<std::runtime_error>("Unable to watch directory '{}' for changes", directory.generic_string());
+
+		try {
+			AddWatches(directory);
+		} catch (...) {
+			close(descriptor);
+			throw;
+		}
+
+		thread = std::jthread{ std::bind_front(&FileWatcher::Watch, this) };
+	}
+
+	FileWatcher::~FileWatcher() {
+		thread.request_stop();
+		if (thread.joinable()) thread.join();
+
+		//Closing the instance also removes all of its watches
+		close(descriptor);
+	}
+
+	void FileWatcher::AddWatches(std::filesystem::path const& path) {
+		constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+
+		int const watch = inotify_add_watch(descriptor, path.c_str(), mask);
+		if (watch < 0) throw FormatType<std::runtime_error>("Unable to watch directory '{}' for changes", path.generic_string());
+		watches[watch] = path;
+
+		std::error_code error;
+		for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator{ path, error }) {
+			if (entry.is_directory(error)) AddWatches(entry.path());
+		}
+	}
+
+	void FileWatcher::Watch(std::stop_token token) {
+		//Events are variable-length, but always aligned to the event structure
+		alignas(inotify_event) std::array<char, 4096> buffer;
+
+		while (!token.stop_requested()) {
+			pollfd request{ descriptor, POLLIN, 0 };
+			if (poll(&request, 1, static_cast<int>(PollInterval.count())) <= 0) continue;
+
+			ssize_t const size = read(descriptor, buffer.data(), buffer.size());
+			if (size <= 0) continue;
+
+			for (ssize_t offset = 0; offset < size;) {
+				inotify_event const& event = *reinterpret_cast<inotify_event const*>(buffer.data() + offset);
+				offset += sizeof(inotify_event) + event.len;
+
+				auto const iter = watches.find(event.wd);
+				if (iter == watches.end() || event.len == 0) continue;
+
+				std::filesystem::path const path = iter->second / event.name;
+				if (event.mask & IN_ISDIR) {
+					//New directories must be watched as well. Files may have been added before the watch was created, so those are reported now.
+					if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+						try {
+							AddWatches(path);
+						} catch (std::exception const&) {
+							//The directory may have been removed again before it could be watched
+							continue;
+						}
+
+						std::error_code error;
+						for (std::filesystem::directory_entry const& entry : std::filesystem::recursive_directory_iterator{ path, error }) {
+							if (entry.is_regular_file(error)) callback(entry.path());
+						}
+					}
+
+				} else if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+					callback(path);
+				}
+			}
+		}
+	}
+#else
+	FileWatcher::FileWatcher(std::filesystem::path const& directory, CallbackType callback)
+		: directory(directory), callback(callback)
+	{
+		ScanWriteTimes();
+		thread = std::jthread{ std::bind_front(&FileWatcher::Watch, this) };
+	}
+
+	FileWatcher::~FileWatcher() {
+		thread.request_stop();
+		if (thread.joinable()) thread.join();
+	}
+
+	std::vector<std::filesystem::path> FileWatcher::ScanWriteTimes() {
+		std::vector<std::filesystem::path> changed;
+
+		std::error_code error;
+		for (std::filesystem::directory_entry const& entry : std::filesystem::recursive_directory_iterator{ directory, error }) {
+			if (!entry.is_regular_file(error)) continue;
+
+			std::filesystem::file_time_type const time = entry.last_write_time(error);
+			if (error) continue;
+
+			auto const [iter, inserted] = write_times.try_emplace(entry.path(), time);
+			if (inserted || iter->second != time) {
+				iter->second = time;
+				changed.emplace_back(entry.path());
+			}
+		}
+
+		return changed;
+	}
+
+	void FileWatcher::Watch(std::stop_token token) {
+		std::mutex mutex;
+		std::condition_variable_any wait;
+
+		while (!token.stop_requested()) {
+			{
+				//Sleep until the next scan, but wake up immediately if a stop is requested
+				std::unique_lock lock{ mutex };
+				wait.wait_for(lock, token, PollInterval, [] { return false; });
+			}
+			if (token.stop_requested()) break;
+
+			for (std::filesystem::path const& path : ScanWriteTimes()) callback(path);
+		}
+	}
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Engine/Core.h"
+#include "Engine/Delegates.h"
+#include "Engine/Map.h"
+#include "Engine/Threads.h"
+
+namespace HAL {
+	/**
+	 * Watches a directory and all of its subdirectories for files that are modified, created, or moved into the directory.
+	 * Changes are detected on a separate thread, which calls the callback with the path of each changed file.
+	 * The same file may be reported several times for a single change, depending on how the file was written.
+	 */
+	struct FileWatcher {
+		using CallbackType = TDelegate<void, std::filesystem::path const&>;
+
+		/** The longest time the watching thread will wait before it checks whether it should stop */
+		static constexpr std::chrono::milliseconds PollInterval{ 250 };
+
+		FileWatcher(std::filesystem::path const& directory, CallbackType callback);
+		FileWatcher(FileWatcher const&) = delete;
+		FileWatcher(FileWatcher&&) = delete;
+		~FileWatcher();
+
+		/** Get the directory that is being watched */
+		inline std::filesystem::path const& GetDirectory() const { return directory; }
+
+	private:
+		std::filesystem::path const directory;
+		CallbackType const callback;
+
+#if defined(__linux__)
+		/** The inotify instance that reports changes */
+		int descriptor = -1;
+		/** The directory that is watched by each watch descriptor. Each subdirectory must be watched separately. */
+		std::unordered_map<int, std::filesystem::path> watches;
+
+		/** Watch a directory and all of its subdirectories */
+		void AddWatches(std::filesystem::path const& path);
+#else
+		/** The last write time of each file, which are compared to find changes on platforms where changes are not reported directly */
+		std::map<std::filesystem::path, std::filesystem::file_time_type> write_times;
+
+		/** Record the write time of each file, and return the files that changed since they were last recorded */
+		std::vector<std::filesystem::path> ScanWriteTimes();
+#endif
+
+		std::jthread thread;
+
+		/** Report changes until the token is stopped. Runs on the watching thread. */
+		void Watch(std::stop_token token);
+	};
+}
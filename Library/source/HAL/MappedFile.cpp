@@ -0,0 +1,83 @@
+#include "HAL/MappedFile.h"
+#include "Engine/Format.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HAL {
+#if defined(_WIN32)
+	MappedFile::MappedFile(std::filesystem::path const& path) {
+		HANDLE const file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) throw FormatType<std::runtime_error>("Unable to open file '{}' for mapping", path.generic_string());
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			throw FormatType<std::runtime_error>("Unable to get the size of file '{}' for mapping", path.generic_string());
+		}
+
+		//Empty files cannot be mapped, but are still valid files with no contents
+		if (size.QuadPart == 0) {
+			CloseHandle(file);
+			return;
+		}
+
+		//The view keeps the mapping alive, so the handles can be closed as soon as the view is created
+		HANDLE const mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!mapping) throw FormatType<std::runtime_error>("Unable to create mapping for file '{}'", path.generic_string());
+
+		void const* const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!view) throw FormatType<std::runtime_error>("Unable to map view of file '{}'", path.generic_string());
+
+		bytes.get() = std::span<std::byte const>{ static_cast<std::byte const*>(view), static_cast<size_t>(size.QuadPart) };
+	}
+
+	MappedFile::~MappedFile() {
+		std::span<std::byte const> const view = bytes;
+		if (view.data()) UnmapViewOfFile(view.data());
+	}
+#else
+	MappedFile::MappedFile(std::filesystem::path const& path) {
+		int const descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (descriptor < 0) throw FormatType<std::runtime_error>("Unable to open file '{}' for mapping", path.generic_string());
+
+		struct stat status;
+		if (fstat(descriptor, &status) != 0) {
+			close(descriptor);
+			throw FormatType<std::runtime_error>("Unable to get the size of file '{}' for mapping", path.generic_string());
+		}
+
+		//Empty files cannot be mapped, but are still valid files with no contents
+		size_t const size = static_cast<size_t>(status.st_size);
+		if (size == 0) {
+			close(descriptor);
+			return;
+		}
+
+		//The mapping keeps the file alive, so the descriptor can be closed as soon as the mapping is created
+		void* const view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+		if (view == MAP_FAILED) throw FormatType<std::runtime_error>("Unable to map file '{}'", path.generic_string());
+
+		//Packages are generally read from start to end, so the kernel can read ahead of the current position
+		madvise(view, size, MADV_SEQUENTIAL);
+
+		bytes.get() = std::span<std::byte const>{ static_cast<std::byte const*>(view), size };
+	}
+
+	MappedFile::~MappedFile() {
+		std::span<std::byte const> const view = bytes;
+		if (view.data()) munmap(const_cast<std::byte*>(view.data()), view.size());
+	}
+#endif
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Engine/Core.h"
+#include "Engine/MoveOnly.h"
+
+namespace HAL {
+	/**
+	 * A read-only view of the contents of a file, which are mapped directly into the address space of the process instead of being copied into memory.
+	 * Pages of the file are only read when they are accessed. The view remains valid while this object exists, including after it is moved.
+	 */
+	struct MappedFile {
+		MappedFile(std::filesystem::path const& path);
+		MappedFile(MappedFile const&) = delete;
+		MappedFile(MappedFile&&) noexcept = default;
+		~MappedFile();
+
+		MappedFile& operator=(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile&&) = delete;
+
+		/** Get the contents of the file */
+		inline std::span<std::byte const> GetBytes() const { return bytes; }
+
+	private:
+		MoveOnly<std::span<std::byte const>> bytes{ std::span<std::byte const>{} };
+	};
+}
@@ -279,6 +279,15 @@ namespace Rendering {
 		MarkMaterialStale(material);
 	}
 
+	void RenderingSystem::OnCreatedBatch(std::span<Resources::Handle<Material> const> materials) {
+		dirtyMaterials.insert(dirtyMaterials.end(), materials.begin(), materials.end());
+	}
+
+	void RenderingSystem::OnUpdated(Resources::Handle<Material> const& material) {
+		//Refreshing a dirty material makes its existing pipeline stale, so it is not destroyed while a frame is still using it
+		MarkMaterialDirty(material);
+	}
+
 	void RenderingSystem::OnCreated(Resources::Handle<StaticMesh> const& mesh) {
 		MarkStaticMeshDirty(mesh);
 	}
@@ -287,6 +296,15 @@ namespace Rendering {
 		MarkStaticMeshStale(mesh);
 	}
 
+	void RenderingSystem::OnCreatedBatch(std::span<Resources::Handle<StaticMesh> const> meshes) {
+		dirtyStaticMeshes.insert(dirtyStaticMeshes.end(), meshes.begin(), meshes.end());
+	}
+
+	void RenderingSystem::OnUpdated(Resources::Handle<StaticMesh> const& mesh) {
+		//Refreshing a dirty mesh makes its existing buffers stale, so they are not destroyed while a frame is still using them
+		MarkStaticMeshDirty(mesh);
+	}
+
 	void RenderingSystem::RefreshMaterials() {
 		//The library of shader modules that will stay loaded as long as we need to continue creating pipelines
 		PipelineCreationHelper helper{ *device };
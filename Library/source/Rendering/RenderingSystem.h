@@ -106,13 +106,17 @@ namespace Rendering {
 		/** Called just before a window is destroyed in the windowing system */
 		void OnDestroyingWindow(HAL::Window::IdType id);
 
-		/** Callbacks for when materials are created or destroyed */
+		/** Callbacks for when materials are created, destroyed, or updated */
 		void OnCreated(Resources::Handle<Material> const& material) final;
 		void OnDestroyed(Resources::Handle<Material> const& material) final;
+		void OnCreatedBatch(std::span<Resources::Handle<Material> const> materials) final;
+		void OnUpdated(Resources::Handle<Material> const& material) final;
 
-		/** Callbacks for when static meshes are created or destroyed */
+		/** Callbacks for when static meshes are created, destroyed, or updated */
 		void OnCreated(Resources::Handle<StaticMesh> const& mesh) final;
 		void OnDestroyed(Resources::Handle<StaticMesh> const& mesh) final;
+		void OnCreatedBatch(std::span<Resources::Handle<StaticMesh> const> meshes) final;
+		void OnUpdated(Resources::Handle<StaticMesh> const& mesh) final;
 
 		/** Refresh dirty materials so they are no longer dirty */
 		void RefreshMaterials();
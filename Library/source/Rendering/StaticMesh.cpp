@@ -10,3 +10,10 @@
 };
 
 REGISTER_RESOURCE(Rendering, StaticMesh);
+
+namespace Rendering {
+	size_t StaticMesh::GetMemorySize() const {
+		const auto GetNumBytes = [](auto const& elements) { return elements.size() * sizeof(elements[0]); };
+		return Resource::GetMemorySize() + std::visit(GetNumBytes, vertices) + std::visit(GetNumBytes, indices);
+	}
+}
@@ -26,6 +26,8 @@ namespace Rendering {
 		FormattedIndices indices;
 
 		std::shared_ptr<MeshResources> objects;
+
+		virtual size_t GetMemorySize() const override;
 	};
 }
 
@@ -78,3 +78,20 @@ namespace Rendering {
 	};
 	static_assert(Concepts::VertexType<Vertex_Complex>);
 }
+
+namespace Archive {
+	/** Vertices are tightly packed with no padding, so they are serialized as their bytes in memory */
+	template<Rendering::Concepts::VertexType T>
+	struct Serializer<T> {
+		static void Write(Output& archive, T const& vertex) {
+			WriteBytes(archive, std::as_bytes(MakeSpan(vertex)));
+		}
+		static void Read(Input& archive, T& vertex) {
+			std::span<std::byte const> const bytes = ReadBytes(archive, sizeof(T));
+			std::memcpy(&vertex, bytes.data(), sizeof(T));
+		}
+	};
+
+	template<Rendering::Concepts::VertexType T>
+	constexpr bool EnableBulkSerialization<T> = std::endian::native == std::endian::little;
+}
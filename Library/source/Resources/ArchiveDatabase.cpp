@@ -0,0 +1,27 @@
+#include "Resources/ArchiveDatabase.h"
+
+namespace Resources {
+	ArchiveDatabase::ArchiveDatabase(std::filesystem::path const& path, size_t num_workers)
+		: StreamingDatabase(num_workers), archive(path)
+	{}
+
+	ArchiveDatabase::~ArchiveDatabase() {
+		StopStreaming();
+	}
+
+	size_t ArchiveDatabase::EstimatePackageSourceSize(StringID name) const {
+		if (PackageArchiveEntry const* entry = archive.Find(name)) return entry->size;
+		else return 0;
+	}
+
+	void ArchiveDatabase::SavePackageContents(StringID name, Package::ContentsContainerType const& contents, std::atomic<float>& progress) {
+		throw FormatType<std::runtime_error>("Unable to save package {}, packages in an archive cannot be modified", name);
+	}
+
+	PackageInput ArchiveDatabase::LoadPackageSource(StringID name) {
+		PackageArchiveEntry const* entry = archive.Find(name);
+		if (!entry) throw FormatType<std::runtime_error>("Package {} not found in archive, unable to load package source", name);
+
+		return archive.Open(*entry);
+	}
+}
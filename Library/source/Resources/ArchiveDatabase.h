@@ -0,0 +1,32 @@
+#pragma once
+#include "Engine/Core.h"
+#include "Resources/PackageArchive.h"
+#include "Resources/Streaming.h"
+
+namespace Resources {
+	/**
+	 * Packages are read from a single archive file, which is built ahead of time from a directory of packages. The archive cannot be modified.
+	 * The archive is opened once, so loading a package does not open any files, and packages that are loaded together can be placed next to each other.
+	 */
+	struct ArchiveDatabase : public StreamingDatabase {
+		ArchiveDatabase(std::filesystem::path const& path, size_t num_workers = GetDefaultWorkerCount());
+		~ArchiveDatabase();
+
+		/** Load a package from the archive. If the package is already loaded, a handle to the loaded package will be returned instead. */
+		PackageRequestHandle LoadPackage(StringID name, RequestPriority priority = DefaultRequestPriority) { return StreamingDatabase::LoadPackage(name, priority); }
+
+		/** Find an existing package by name */
+		std::shared_ptr<Package const> FindPackage(StringID name) const { return Database::FindPackage(name); }
+
+		/** Returns true if the archive contains the package. Does not check if the package is loaded. */
+		bool IsPackageArchived(StringID name) const { return archive.Find(name) != nullptr; }
+
+	protected:
+		virtual size_t EstimatePackageSourceSize(StringID name) const override final;
+		virtual void SavePackageContents(StringID name, Package::ContentsContainerType const& contents, std::atomic<float>& progress) override final;
+		virtual PackageInput LoadPackageSource(StringID name) override final;
+
+	private:
+		PackageArchiveInput const archive;
+	};
+}
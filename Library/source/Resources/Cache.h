@@ -1,4 +1,5 @@
 #pragma once
+#include "Engine/Allocators.h"
 #include "Engine/Array.h"
 #include "Engine/Events.h"
 #include "Engine/Core.h"
@@ -12,11 +13,33 @@
 #include "Resources/ResourceUtility.h"
 
 namespace Resources {
+	/** Limits the amount of work that is performed by a single garbage collection call */
+	struct GarbageCollectionBudget {
+		/** The maximum number of resources that will be scanned */
+		size_t max_scanned = std::numeric_limits<size_t>::max();
+		/** The maximum amount of time that will be spent scanning resources. The time is checked periodically, so it may be slightly exceeded. If zero, the time is not limited. */
+		std::chrono::microseconds max_duration = std::chrono::microseconds::zero();
+	};
+
+	/** Statistics about the resources in a cache */
+	struct CacheStatistics {
+		/** Resources that were being used as of the last complete scan */
+		size_t num_live = 0;
+		size_t live_bytes = 0;
+		/** Resources that are no longer being used, but are retained in case they are needed again */
+		size_t num_retained = 0;
+		size_t retained_bytes = 0;
+		/** Resources that were destroyed since the cache was created */
+		size_t num_evicted = 0;
+		size_t evicted_bytes = 0;
+	};
+
 	/**
 	 * Base class for caches that manage a specific type of resource.
 	 * Caches allow systems to easily and efficiently iterate over all resources of a given type. The order of iteration is unspecified.
-	 * The resources within a cache are unnamed, identified only by their handles. A garbage collection pass can be performed to clean
-	 * up resources that are no longer being used.
+	 * Iteration does not lock the cache, so resources can be created on other threads while systems are iterating.
+	 * The resources within a cache are unnamed, identified only by their handles. Garbage collection is performed incrementally to clean
+	 * up resources that are no longer being used. Recently used resources are retained up to a memory budget before they are destroyed.
 	 * Systems can also listen for events that are broadcast whenever a resource is created or destroyed, which allows them to perform
 	 * bookkeeping related to the resource (such as uploading mesh data to a GPU for a static mesh resource).
 	 */
@@ -24,14 +47,32 @@ namespace Resources {
 		virtual ~Cache() = default;
 
 		/**
-		 * Destroy resources that are unused. If limit is not 0, this specifies some quantity that should not be exceeded during
-		 * this call, possibly leaving unused resources in place if the limit is reached. The exact meaning of the limit is type-specific
-		 * for the cache, but generally corresponds to the maximum number of individual resources that will be cleaned.
+		 * Scan a portion of the resources in the cache to find resources that are unused, continuing from where the previous call stopped.
+		 * Unused resources are retained, and the least recently used retained resources are destroyed once the retention budget is exceeded.
+		 * A single call never scans the same resource twice. Returns the number of resources that were destroyed.
 		 */
-		virtual size_t CollectGarbage(size_t limit = std::numeric_limits<size_t>::max()) = 0;
+		virtual size_t CollectGarbage(GarbageCollectionBudget const& budget = GarbageCollectionBudget{}) = 0;
+
+		/** Get statistics about the resources in the cache */
+		virtual CacheStatistics GetStatistics() const = 0;
 
 		/** Create a resource, using the initializer function to assign values before notifying external systems about the new resource */
 		virtual std::shared_ptr<Resource> Create(StringID name, FunctionRef<void(Resource&)> initializer) = 0;
+		/**
+		 * Create several resources at once. The initializer is called with each resource and its index, and may be called from multiple threads at the same time.
+		 * External systems are notified about all the new resources at once. If any initializer throws, external systems are only notified about
+		 * the resources that were initialized, and the first exception is rethrown once the other resources have been created.
+		 */
+		virtual std::vector<std::shared_ptr<Resource>> CreateBatch(std::span<StringID const> names, FunctionRef<void(Resource&, size_t)> initializer) = 0;
+		/** Modify the contents of an existing resource in place, then notify external systems that it was updated. The resource must have been created by this cache. */
+		virtual void Update(Resource& resource, FunctionRef<void(Resource&)> updater) = 0;
+
+		/** Set the number of bytes of unused resources that will be retained. If zero, unused resources are destroyed as soon as they are found. */
+		inline void SetRetentionBudget(size_t bytes) { retention_budget = bytes; }
+		inline size_t GetRetentionBudget() const { return retention_budget; }
+
+	protected:
+		std::atomic<size_t> retention_budget = 0;
 	};
 
 	/** An observer that can listen for when resources are created or destroyed by a specific cache */
@@ -39,6 +80,16 @@ namespace Resources {
 	struct Observer {
 		virtual void OnCreated(Handle<ResourceType> const& handle) = 0;
 		virtual void OnDestroyed(Handle<ResourceType> const& handle) = 0;
+
+		/** Called when several resources are created at once. By default, this is equivalent to calling OnCreated for each resource. */
+		virtual void OnCreatedBatch(std::span<Handle<ResourceType> const> handles) {
+			for (Handle<ResourceType> const& handle : handles) OnCreated(handle);
+		}
+		/** Called when the contents of an existing resource are replaced in place, such as when it is reloaded. By default, this is equivalent to destroying and creating the resource. */
+		virtual void OnUpdated(Handle<ResourceType> const& handle) {
+			OnDestroyed(handle);
+			OnCreated(handle);
+		}
 	};
 
 	/** A cache that manages a specific type of resource */
@@ -53,49 +104,70 @@ namespace Resources {
 			if (iter != observers.end()) observers.erase(iter);
 		}
 
-		virtual size_t CollectGarbage(size_t limit) override {
-			auto resources = ts_resources.LockExclusive();
+		virtual size_t CollectGarbage(GarbageCollectionBudget const& budget = GarbageCollectionBudget{}) override {
+			auto const start = std::chrono::steady_clock::now();
+			auto contents = ts_contents.LockExclusive();
 
-			size_t count = 0;
+			size_t const num_evicted = contents->statistics.num_evicted;
 
-			//Pop unused back elements first, stopping if we exceed the limit.
-			while (count < limit && resources->size() > 0 && resources->back().use_count() == 1) {
-				NotifyDestroyed(resources->back());
-				resources->pop_back();
-				++count;
-			}
+			size_t num_scanned = 0;
+			while (num_scanned < budget.max_scanned) {
+				if (contents->scan_position >= contents->resources.size()) {
+					//The scan is complete. The next call will start a new scan from the beginning.
+					FinishScan(*contents);
+					break;
+				}
 
-			//If we still haven't reached the limit, move on to the other elements.
-			if (count < limit) {
-
-				//Iterate backwards through the container and perform a swap-and-pop on any unused elements.
-				//Thanks to the loop above, we know that the last element is currently in-use, so we can start from the second-to-last element.
-				//We can also iterate using one larger than the index to avoid underflow issues with the index.
-				for (size_t rnum = resources->size() - 1; count < limit && rnum > 0; --rnum) {
-					const size_t rindex = rnum - 1;
-
-					auto& resource = resources[rindex];
-					if (resource.use_count() == 1) {
-						std::swap(resource, resources->back());
-						NotifyDestroyed(resources->back());
-						resources->pop_back();
-						++count;
-					}
+				//Checking the time is relatively expensive compared to scanning a single resource, so it is only checked periodically
+				if (budget.max_duration.count() > 0 && num_scanned > 0 && (num_scanned % TimeCheckInterval) == 0) {
+					if (std::chrono::steady_clock::now() - start >= budget.max_duration) break;
+				}
+
+				++num_scanned;
+				std::shared_ptr<ResourceType>& resource = contents->resources[contents->scan_position];
+
+				if (resource.use_count() == 1) {
+					//Only the cache is using this resource. It becomes the most recently used retained resource.
+					size_t const bytes = resource->GetMemorySize();
+					contents->retained.emplace_back(std::move(resource), bytes);
+					contents->statistics.num_retained += 1;
+					contents->statistics.retained_bytes += bytes;
+
+					//Swap-and-pop to remove the empty entry. The swapped element has not been scanned yet, so the position does not advance.
+					std::swap(resource, contents->resources.back());
+					contents->resources.pop_back();
+
+				} else {
+					contents->scan_live += 1;
+					contents->scan_live_bytes += resource->GetMemorySize();
+					++contents->scan_position;
 				}
 			}
 
-			return count;
+			EvictRetained(*contents);
+
+			//Evicted resources are skipped by readers, but they still take up space in the generation until it is rebuilt
+			size_t const num_handles = contents->resources.size() + contents->retained.size();
+			if (contents->num_stale_handles > 0 && contents->num_stale_handles * StaleHandleRatio >= num_handles) RebuildGeneration(*contents);
+
+			return contents->statistics.num_evicted - num_evicted;
+		}
+
+		virtual CacheStatistics GetStatistics() const override {
+			auto const contents = ts_contents.LockInclusive();
+			return contents->statistics;
 		}
 
 		virtual std::shared_ptr<Resource> Create(StringID name, FunctionRef<void(Resource&)> initializer) override final {
 			//Create the new resource object.
-			std::shared_ptr<ResourceType> const resource = std::make_shared<ResourceType>(name);
+			std::shared_ptr<ResourceType> const resource = std::allocate_shared<ResourceType>(TPoolAllocator<ResourceType>{ pool }, name);
 
 			//Record the new resource entry. The amount of bookkeeping needed is minimal here, so we release the lock as soon as the information is recorded.
 			//Releasing the lock also means the initializer can be recursive and potentially create other resources.
 			{
-				auto resources = ts_resources.LockExclusive();
-				resources->emplace_back(resource);
+				auto contents = ts_contents.LockExclusive();
+				contents->resources.emplace_back(resource);
+				AppendToGeneration(resource);
 			}
 
 			//Call the initializer to load data into the resource
@@ -106,26 +178,271 @@ namespace Resources {
 			return resource;
 		}
 
-		/** Perform an operation on all resources in this cache. Stops iterating when the operation returns false. */
+		virtual std::vector<std::shared_ptr<Resource>> CreateBatch(std::span<StringID const> names, FunctionRef<void(Resource&, size_t)> initializer) override final {
+			std::vector<std::shared_ptr<ResourceType>> resources;
+			resources.reserve(names.size());
+			for (StringID const name : names) resources.emplace_back(std::allocate_shared<ResourceType>(TPoolAllocator<ResourceType>{ pool }, name));
+
+			//Record all the new resource entries while the lock is held once
+			{
+				auto contents = ts_contents.LockExclusive();
+				contents->resources.insert(contents->resources.end(), resources.begin(), resources.end());
+				for (std::shared_ptr<ResourceType> const& resource : resources) AppendToGeneration(resource);
+			}
+
+			//Call the initializers in parallel. Exceptions cannot escape a parallel algorithm, so they are captured for each resource and rethrown afterwards.
+			std::vector<std::exception_ptr> exceptions{ resources.size() };
+			std::for_each(
+				std::execution::par, resources.begin(), resources.end(),
+				[&](std::shared_ptr<ResourceType> const& resource) {
+					size_t const index = &resource - resources.data();
+					try {
+						initializer(*resource, index);
+					} catch (...) {
+						exceptions[index] = std::current_exception();
+					}
+				}
+			);
+
+			//Resources that failed to initialize are left for garbage collection, the same as when a single resource fails
+			auto const first_exception = ranges::find_if(exceptions, [](std::exception_ptr const& exception) { return static_cast<bool>(exception); });
+			if (first_exception != exceptions.end()) {
+				std::vector<std::shared_ptr<ResourceType>> initialized;
+				for (size_t index = 0; index < resources.size(); ++index) {
+					if (!exceptions[index]) initialized.emplace_back(resources[index]);
+				}
+
+				NotifyCreatedBatch(initialized);
+				std::rethrow_exception(*first_exception);
+			}
+
+			//Broadcast to external systems that the resources have been created
+			NotifyCreatedBatch(resources);
+
+			return std::vector<std::shared_ptr<Resource>>{ resources.begin(), resources.end() };
+		}
+
+		virtual void Update(Resource& resource, FunctionRef<void(Resource&)> updater) override final {
+			updater(resource);
+			NotifyUpdated(std::static_pointer_cast<ResourceType>(resource.shared_from_this()));
+		}
+
+		/**
+		 * Perform an operation on all resources in this cache, including retained resources. Stops iterating when the operation returns false.
+		 * Iterates over the generation that is current when this is called without locking the cache. Resources created during iteration may not be included.
+		 */
 		template<typename OperationType>
 			requires std::is_invocable_r_v<bool, OperationType, ResourceType&>
 		void ForEachResource(OperationType&& operation) const {
-			auto const resources = ts_resources.LockInclusive();
+			std::shared_ptr<Generation const> const current = generation.load();
+			size_t const num_handles = current->num_handles.load(std::memory_order_acquire);
 
-			for (auto const& handle : *resources) {
-				if (!operation(*handle)) break;
+			for (size_t index = 0; index < num_handles; ++index) {
+				//Handles to resources that were destroyed after this generation was created, or that are being destroyed, are skipped
+				if (std::shared_ptr<ResourceType> const resource = LockHandle(current->chunks[index / ChunkSize]->handles[index % ChunkSize])) {
+					if (!operation(*resource)) return;
+				}
 			}
 		}
 
+		/**
+		 * Perform an operation on all resources in this cache, including retained resources, using multiple threads.
+		 * The operation may be called concurrently for different resources, and the order is unspecified. Every resource that is not being evicted is visited.
+		 */
+		template<typename OperationType>
+			requires std::is_invocable_v<OperationType, ResourceType&>
+		void ParallelForEachResource(OperationType&& operation) const {
+			std::shared_ptr<Generation const> const current = generation.load();
+			size_t const num_handles = current->num_handles.load(std::memory_order_acquire);
+
+			//Each chunk is processed by a single thread, so threads never share the handles they are reading
+			std::for_each(
+				std::execution::par, current->chunks.begin(), current->chunks.end(),
+				[&](std::shared_ptr<Chunk> const& chunk) {
+					ForEachResourceInChunk(*current, chunk, num_handles, [&](ResourceType& resource) { operation(resource); });
+				}
+			);
+		}
+
+		/**
+		 * Transform all resources in this cache into values using multiple threads, then combine the values into a single result.
+		 * The identity is the initial value, and must not change a value it is combined with. The reduction must be associative and commutative.
+		 */
+		template<typename ValueType, typename ReductionType, typename TransformType>
+			requires std::is_invocable_r_v<ValueType, TransformType, ResourceType&> && std::is_invocable_r_v<ValueType, ReductionType, ValueType, ValueType>
+		ValueType ParallelTransformReduceResources(ValueType identity, ReductionType&& reduction, TransformType&& transform) const {
+			std::shared_ptr<Generation const> const current = generation.load();
+			size_t const num_handles = current->num_handles.load(std::memory_order_acquire);
+
+			//Values are combined within each chunk first, so the parallel reduction only needs to combine one value per chunk
+			return std::transform_reduce(
+				std::execution::par, current->chunks.begin(), current->chunks.end(), identity, reduction,
+				[&](std::shared_ptr<Chunk> const& chunk) {
+					ValueType result = identity;
+					ForEachResourceInChunk(*current, chunk, num_handles, [&](ResourceType& resource) { result = reduction(std::move(result), transform(resource)); });
+					return result;
+				}
+			);
+		}
+
 	protected:
-		ThreadSafe<std::deque<std::shared_ptr<ResourceType>>> ts_resources;
+		/** A resource which is no longer being used, but has not been destroyed yet */
+		struct RetainedResource {
+			std::shared_ptr<ResourceType> resource;
+			/** The memory used by the resource when it was retained */
+			size_t bytes = 0;
+		};
+
+		struct CacheContents {
+			/** Resources which were being used when they were last scanned, or which have not been scanned yet */
+			std::deque<std::shared_ptr<ResourceType>> resources;
+			/** Resources which are retained, ordered from least recently used to most recently used */
+			std::deque<RetainedResource> retained;
+
+			/** The position in the resources of the next resource that will be scanned */
+			size_t scan_position = 0;
+			/** The live resources that were found by the scan in progress */
+			size_t scan_live = 0;
+			size_t scan_live_bytes = 0;
+
+			/** The number of handles in the current generation to resources that were destroyed */
+			size_t num_stale_handles = 0;
+
+			CacheStatistics statistics;
+		};
+
+		/** The number of handles contained in each chunk of a generation */
+		static constexpr size_t ChunkSize = 64;
+		/** A fixed-size array of handles. Each handle is written once, before it becomes visible to readers. */
+		struct Chunk {
+			std::array<std::weak_ptr<ResourceType>, ChunkSize> handles;
+		};
+
+		/**
+		 * The handles to all resources in the cache, which readers can iterate without locking.
+		 * New handles are appended after the visible handles, so a generation can be extended without affecting readers.
+		 * When the last chunk is full, a new generation is created which shares the existing chunks with the previous generation.
+		 */
+		struct Generation {
+			std::vector<std::shared_ptr<Chunk>> chunks;
+			/** The number of handles that are visible to readers */
+			std::atomic<size_t> num_handles = 0;
+		};
+
+		/** The number of resources that are scanned between checks of the time budget */
+		static constexpr size_t TimeCheckInterval = 64;
+		/** The generation is rebuilt once at least one in this many handles are stale */
+		static constexpr size_t StaleHandleRatio = 4;
+
+		/** Storage for resources of this type, which keeps resources that are created together close in memory and recycles the memory of evicted resources */
+		std::shared_ptr<BlockPool> pool = std::make_shared<BlockPool>();
+		ThreadSafe<CacheContents> ts_contents;
+		/** The current generation, which is only modified while the contents are locked */
+		std::atomic<std::shared_ptr<Generation>> generation{ std::make_shared<Generation>() };
 		std::vector<Observer<ResourceType>*> observers;
 
 		void NotifyCreated(std::shared_ptr<ResourceType> const& resource) {
 			for (auto* observer : observers) { observer->OnCreated(resource); }
 		}
+		void NotifyCreatedBatch(std::span<std::shared_ptr<ResourceType> const> resources) {
+			if (resources.empty()) return;
+			for (auto* observer : observers) { observer->OnCreatedBatch(resources); }
+		}
 		void NotifyDestroyed(std::shared_ptr<ResourceType> const& resource) {
 			for (auto* observer : observers) { observer->OnDestroyed(resource); }
 		}
+		void NotifyUpdated(std::shared_ptr<ResourceType> const& resource) {
+			for (auto* observer : observers) { observer->OnUpdated(resource); }
+		}
+
+		static void FinishScan(CacheContents& contents) {
+			contents.statistics.num_live = contents.scan_live;
+			contents.statistics.live_bytes = contents.scan_live_bytes;
+
+			contents.scan_position = 0;
+			contents.scan_live = 0;
+			contents.scan_live_bytes = 0;
+		}
+
+		/** Destroy the least recently used retained resources until the retained resources fit within the budget */
+		void EvictRetained(CacheContents& contents) {
+			size_t const budget = retention_budget;
+
+			while (contents.retained.size() > 0 && contents.statistics.retained_bytes > budget) {
+				RetainedResource& oldest = contents.retained.front();
+
+				//Readers lock handles without locking the cache, so the resource is marked before checking whether it is used. Pairs with the fence in LockHandle.
+				oldest.resource->evicting.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				if (oldest.resource.use_count() > 1) {
+					//The resource was used again while it was retained, so it is returned to the resources that will be scanned
+					oldest.resource->evicting.store(false, std::memory_order_relaxed);
+					contents.resources.emplace_back(std::move(oldest.resource));
+				} else {
+					NotifyDestroyed(oldest.resource);
+					contents.statistics.num_evicted += 1;
+					contents.statistics.evicted_bytes += oldest.bytes;
+					contents.num_stale_handles += 1;
+				}
+
+				contents.statistics.num_retained -= 1;
+				contents.statistics.retained_bytes -= oldest.bytes;
+				contents.retained.pop_front();
+			}
+		}
+
+		/** Perform an operation on the resources in a chunk of the generation which are visible and still exist */
+		template<typename OperationType>
+		static void ForEachResourceInChunk(Generation const& current, std::shared_ptr<Chunk> const& chunk, size_t num_handles, OperationType&& operation) {
+			size_t const first = static_cast<size_t>(&chunk - current.chunks.data()) * ChunkSize;
+			size_t const num_chunk_handles = first < num_handles ? std::min(num_handles - first, ChunkSize) : 0;
+
+			for (size_t index = 0; index < num_chunk_handles; ++index) {
+				if (std::shared_ptr<ResourceType> const resource = LockHandle(chunk->handles[index])) operation(*resource);
+			}
+		}
+
+		/** Make a new resource visible to readers. Must be called while the contents are locked. */
+		void AppendToGeneration(std::shared_ptr<ResourceType> const& resource) {
+			std::shared_ptr<Generation> current = generation.load();
+			size_t const index = current->num_handles.load(std::memory_order_relaxed);
+
+			if (index == current->chunks.size() * ChunkSize) {
+				//Readers may still be using the chunks of the current generation, so a new generation is needed to add another chunk
+				std::shared_ptr<Generation> next = std::make_shared<Generation>();
+				next->chunks.reserve(current->chunks.size() + 1);
+				next->chunks = current->chunks;
+				next->chunks.emplace_back(std::make_shared<Chunk>());
+				next->num_handles.store(index, std::memory_order_relaxed);
+
+				generation.store(next);
+				current = std::move(next);
+			}
+
+			//The handle is written before the count is increased, so readers never see a handle that is not fully written
+			current->chunks[index / ChunkSize]->handles[index % ChunkSize] = resource;
+			current->num_handles.store(index + 1, std::memory_order_release);
+		}
+
+		/** Replace the current generation with one that only contains handles to existing resources. Must be called while the contents are locked. */
+		void RebuildGeneration(CacheContents& contents) {
+			std::shared_ptr<Generation> const next = std::make_shared<Generation>();
+
+			size_t index = 0;
+			const auto Append = [&](std::shared_ptr<ResourceType> const& resource) {
+				if ((index % ChunkSize) == 0) next->chunks.emplace_back(std::make_shared<Chunk>());
+				next->chunks.back()->handles[index % ChunkSize] = resource;
+				++index;
+			};
+
+			for (auto const& resource : contents.resources) Append(resource);
+			for (auto const& retained : contents.retained) Append(retained.resource);
+
+			next->num_handles.store(index, std::memory_order_relaxed);
+			generation.store(next);
+
+			contents.num_stale_handles = 0;
+		}
 	};
 }
@@ -13,14 +13,7 @@ namespace Resources {
 	}
 
 	std::shared_ptr<Resource> Database::FindResource(Identifier id) const noexcept {
-		auto const packages = ts_packages.LockInclusive();
-		if (auto const package_iter = packages->find(id.package); package_iter != packages->end()) {
-			auto const contents = package_iter->second->ts_contents.LockInclusive();
-			if (auto const resource_iter = contents->find(id.resource); resource_iter != contents->end()) {
-				return resource_iter->second;
-			}
-		}
-		return nullptr;
+		return index.Find(id);
 	}
 
 	std::shared_ptr<Package> Database::FindPackage(StringID name) const noexcept {
@@ -68,6 +61,8 @@ namespace Resources {
 			if (!CanCreatePackage(name)) throw FormatType<std::runtime_error>("Cannot create package named {}. This package likely already exists, but is not loaded.", name);
 
 			auto const result = packages->emplace(make_pair(name, make_shared<Package>(shared_from_this(), name, contents)));
+			for (auto const& [resource_name, resource] : contents) index.Insert(Identifier{ name, resource_name }, resource);
+
 			return result.first->second;
 		}
 	}
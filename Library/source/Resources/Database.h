@@ -6,6 +6,7 @@
 #include "Engine/Threads.h"
 #include "Resources/Cache.h"
 #include "Resources/Resource.h"
+#include "Resources/ResourceIndex.h"
 
 namespace Resources {
 	struct Package;
@@ -56,6 +57,8 @@ namespace Resources {
 
 		ThreadSafe<std::unordered_map<StringID, std::shared_ptr<Package>>> ts_packages;
 		ThreadSafe<std::unordered_map<Hash128, std::shared_ptr<Cache>>> ts_caches;
+		/** An index of all resources in the packages of this database, which allows resources to be found without locking the packages */
+		ResourceIndex index;
 
 		/** Find an existing package by name */
 		std::shared_ptr<Package> FindPackage(StringID name) const noexcept;
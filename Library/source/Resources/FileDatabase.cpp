@@ -2,21 +2,146 @@
 #include "yaml-cpp/yaml.h"
 
 namespace Resources {
+	FileDatabase::~FileDatabase() {
+		StopWatching();
+		StopStreaming();
+	}
+
 	void FileDatabase::ReloadPackage(StringID name) {
-		//@todo Implement this. Not sure what the best way is to handle this. We can replace most resource contents in-place,
-		//      but we also need to restore deleted resources and delete added resources.
+		std::shared_ptr<Package> const package = FindPackage(name);
+		if (!package || !IsPackageSaved(name)) return;
+
+		PackageInput source = LoadPackageSource(name);
+		ReloadPackageContents(package, source);
+
+		//Resources that were added or removed make the package dirty, but it now matches what is on disk
+		package->flags -= EPackageFlags::Dirty;
+	}
+
+	void FileDatabase::StartWatching() {
+		if (watcher) return;
+
+		std::filesystem::create_directories(GetContentDirectory());
+		watcher = std::make_unique<HAL::FileWatcher>(GetContentDirectory(), HAL::FileWatcher::CallbackType::Create(this, &FileDatabase::OnFileChanged));
+		reload_thread = std::jthread{ std::bind_front(&FileDatabase::ReadChangedPackages, this) };
+	}
+
+	void FileDatabase::StopWatching() {
+		//The watcher must be stopped first, since it may add more packages that need to be read
+		watcher.reset();
+
+		reload_thread.request_stop();
+		if (reload_thread.joinable()) reload_thread.join();
+	}
+
+	size_t FileDatabase::ApplyReloads() {
+		std::vector<std::pair<StringID, PackageInput>> ready;
+		{
+			auto reloads = ts_reloads.LockExclusive();
+			std::swap(ready, reloads->ready);
+		}
+
+		size_t num_reloaded = 0;
+		for (auto& [name, source] : ready) {
+			if (ApplyReload(name, source)) ++num_reloaded;
+		}
+		return num_reloaded;
+	}
+
+	void FileDatabase::OnFileChanged(std::filesystem::path const& path) {
+		std::optional<StringID> const name = GetPackageName(path);
+		//Packages that are not loaded will read the new file when they are loaded
+		if (!name || !ContainsPackage(*name)) return;
+
+		//Saving a package writes its file, which should not cause the package to be reloaded
+		{
+			std::error_code error;
+			auto const time = std::filesystem::last_write_time(path, error);
+
+			auto const saved_times = ts_saved_times.LockInclusive();
+			auto const iter = saved_times->find(*name);
+			if (!error && iter != saved_times->end() && iter->second == time) return;
+		}
+
+		{
+			auto reloads = ts_reloads.LockExclusive();
+			reloads->changed.insert_or_assign(*name, std::chrono::steady_clock::now());
+		}
+		ts_reloads.Notify();
+	}
+
+	void FileDatabase::ReadChangedPackages(std::stop_token token) {
+		std::stop_callback const wake_on_stop{ token, [this]() {
+			{ auto const reloads = ts_reloads.LockInclusive(); }
+			ts_reloads.Notify();
+		} };
+
+		while (!token.stop_requested()) {
+			//Take the packages that have not changed recently, which are likely to be completely written
+			std::vector<StringID> names;
+			{
+				auto reloads = ts_reloads.WaitExclusive([&](PendingReloads const& reloads) {
+					return token.stop_requested() || reloads.changed.size() > 0;
+				});
+				if (token.stop_requested()) return;
+
+				auto const now = std::chrono::steady_clock::now();
+				std::erase_if(reloads->changed, [&](auto const& pair) {
+					if (now - pair.second < ReloadDelay) return false;
+					names.emplace_back(pair.first);
+					return true;
+				});
+			}
+
+			if (names.empty()) {
+				//Wait for the remaining packages to settle, but stop waiting immediately if the thread is stopping
+				auto const wait = ts_reloads.WaitInclusive(ReloadDelay, [&](PendingReloads const&) { return token.stop_requested(); });
+				continue;
+			}
+
+			for (StringID const name : names) {
+				try {
+					PackageInput source = LoadPackageSource(name);
+
+					//If the package was read again before the previous source was applied, only the newest source is kept
+					auto reloads = ts_reloads.LockExclusive();
+					auto const iter = ranges::find(reloads->ready, name, [](auto const& pair) { return pair.first; });
+					if (iter != reloads->ready.end()) reloads->ready.erase(iter);
+					reloads->ready.emplace_back(name, std::move(source));
+
+				} catch (std::exception const& e) {
+					LOG(Resources, Warning, "Unable to read changed package {}, it will not be reloaded: {}", name, e.what());
+				}
+			}
+		}
+	}
+
+	bool FileDatabase::ApplyReload(StringID name, PackageInput& source) {
+		std::shared_ptr<Package> const package = FindPackage(name);
+		if (!package) return false;
+
+		if (package->flags.Has(EPackageFlags::Dirty)) {
+			LOG(Resources, Warning, "Package {} was changed on disk, but it will not be reloaded because it has unsaved changes", name);
+			return false;
+		}
+
+		size_t const num_changed = ReloadPackageContents(package, source);
+		package->flags -= EPackageFlags::Dirty;
+
+		LOG(Resources, Info, "Reloaded package {}, {} resources were changed", name, num_changed);
+		return true;
 	}
 
 	void FileDatabase::DeletePackage(StringID name) {
-		//@todo If package saving is performed on another thread, we'll need to sync this with the thread.
-		//      Deleting a package that is pending a save should also cancel the save, if nothing else.
-		std::filesystem::path const path = GetPath(name);
-		std::filesystem::remove(path);
+		//A pending save would recreate the files after they are deleted
+		CancelSave(name);
+
+		std::filesystem::remove(GetPath(name));
+		std::filesystem::remove(GetBinaryPath(name));
 	}
 
 	bool FileDatabase::IsPackageSaved(StringID name) const {
-		std::filesystem::path const path = GetPath(name);
-		return std::filesystem::exists(path);
+		return std::filesystem::exists(GetPath(name)) || std::filesystem::exists(GetBinaryPath(name));
 	}
 
 	bool FileDatabase::CanCreatePackage(StringID name) const {
@@ -24,19 +149,51 @@ namespace Resources {
 		return !IsPackageSaved(name);
 	}
 
-	bool FileDatabase::SavePackage(Package const& package) {
-		PackageOutput_YAML const source{ package };
+	void FileDatabase::SavePackageContents(StringID name, Package::ContentsContainerType const& contents, std::atomic<float>& progress) {
+		PackageOutput_YAML const source{ contents };
+		progress = 0.5f;
 
-		std::filesystem::path const path = GetPath(package.GetName());
+		std::filesystem::path const path = GetPath(name);
+		std::filesystem::path temporary_path = path;
+		temporary_path += ".tmp"sv;
 
-		//@todo File output should be handled by a separate thread, rather than blocking the calling thread here.
-		std::ofstream file{ path, std::ios_base::out | std::ios_base::trunc };
-		if (file.is_open() && file.good()) file << source.root;
+		//Write to a temporary file first, then replace the original file. The original is never left partially written if saving fails.
+		try {
+			{
+				std::ofstream file{ temporary_path, std::ios_base::out | std::ios_base::trunc };
+				if (!file.is_open() || !file.good()) throw FormatType<std::runtime_error>("Unable to open file '{}' to save package {}", temporary_path.generic_string(), name);
 
-		return true;
+				source.Write(file);
+				file.close();
+				if (file.fail()) throw FormatType<std::runtime_error>("Unable to write file '{}' to save package {}", temporary_path.generic_string(), name);
+			}
+
+			//Renaming keeps the write time, so it is recorded before the file is renamed and might be seen by the watcher
+			{
+				auto saved_times = ts_saved_times.LockExclusive();
+				saved_times->insert_or_assign(name, std::filesystem::last_write_time(temporary_path));
+			}
+
+			std::filesystem::rename(temporary_path, path);
+
+		} catch (...) {
+			//The temporary file is removed so a failed save does not leave it behind. Failing to remove it is ignored, since the original error is more useful.
+			std::error_code error;
+			std::filesystem::remove(temporary_path, error);
+			throw;
+		}
+	}
+
+	size_t FileDatabase::EstimatePackageSourceSize(StringID name) const {
+		std::error_code error;
+		auto const size = std::filesystem::file_size(ShouldLoadBinary(name) ? GetBinaryPath(name) : GetPath(name), error);
+		return error ? 0 : static_cast<size_t>(size);
 	}
 
 	PackageInput FileDatabase::LoadPackageSource(StringID name) {
+		//Binary packages are mapped directly into memory, so resources can be deserialized without copying or parsing the whole file first
+		if (ShouldLoadBinary(name)) return PackageInput_Binary{ GetBinaryPath(name) };
+
 		std::filesystem::path const path = GetPath(name);
 
 		if (!std::filesystem::exists(path)) throw FormatType<std::runtime_error>("File '{}' not found, unable to load package source", path.generic_string());
@@ -45,8 +202,36 @@ namespace Resources {
 		return PackageInput_YAML{ file };
 	}
 
+	std::filesystem::path FileDatabase::GetContentDirectory() {
+		return std::filesystem::current_path() / "content"sv;
+	}
+
+	std::optional<StringID> FileDatabase::GetPackageName(std::filesystem::path const& path) {
+		if (path.extension() != ".yaml"sv && path.extension() != ".bin"sv) return std::nullopt;
+
+		std::filesystem::path const relative = path.lexically_relative(GetContentDirectory());
+		if (relative.empty() || *relative.begin() == ".."sv) return std::nullopt;
+
+		return StringID{ std::filesystem::path{ relative }.replace_extension().generic_string() };
+	}
+
 	std::filesystem::path FileDatabase::GetPath(StringID name) {
 		std::string_view const view = name.ToStringView();
-		return std::filesystem::current_path() / "content"sv / std::filesystem::path{view}.replace_extension("yaml");
+		return GetContentDirectory() / std::filesystem::path{view}.replace_extension("yaml");
+	}
+
+	std::filesystem::path FileDatabase::GetBinaryPath(StringID name) {
+		std::string_view const view = name.ToStringView();
+		return GetContentDirectory() / std::filesystem::path{view}.replace_extension("bin");
+	}
+
+	bool FileDatabase::ShouldLoadBinary(StringID name) {
+		std::error_code error;
+		auto const binary_time = std::filesystem::last_write_time(GetBinaryPath(name), error);
+		if (error) return false;
+
+		//Packages are saved in the editable format, so a binary package that is older than the editable package is out of date
+		auto const editable_time = std::filesystem::last_write_time(GetPath(name), error);
+		return error || binary_time >= editable_time;
 	}
 }
@@ -1,10 +1,14 @@
 #pragma once
 #include "Engine/Core.h"
+#include "HAL/FileWatcher.h"
 #include "Resources/Streaming.h"
 
 namespace Resources {
 	/** Packages correspond to files on disk. They can be modified arbitrarily. */
 	struct FileDatabase : public StreamingDatabase {
+		using StreamingDatabase::StreamingDatabase;
+		~FileDatabase();
+
 		/** Create a new empty package with the provided name. If the package cannot be created, an exception will be thrown. */
 		std::shared_ptr<Package> CreatePackage(StringID name) { return Database::CreatePackage(name); }
 		/** Destroy an existing package by name. If the package is being used and cannot be destroyed, an exception will be thrown. */
@@ -19,12 +23,30 @@ namespace Resources {
 		template<Concepts::DerivedFromResource T, std::invocable<T&> InitializerType>
 		std::shared_ptr<T> Create(StringID name, std::shared_ptr<Package> package, InitializerType&& initializer) { return Database::Create<T>(name, package, std::forward<InitializerType>(initializer)); }
 		
-		/** Save changes to a package to disk. Will create a file for the package if it doesn't already exist. */
+		/** Save changes to a package to disk, blocking until they are saved. Will create a file for the package if it doesn't already exist. */
 		void SavePackage(StringID name) { StreamingDatabase::SavePackage(name); }
+		/** Save changes to a package to disk without blocking. Will create a file for the package if it doesn't already exist. */
+		PackageSaveHandle SavePackageAsync(StringID name) { return StreamingDatabase::SavePackageAsync(name); }
 
-		/** Reload the package from disk, discarding any unsaved changes that were made to the package. Does nothing if the package has no on-disk representation. */
+		/**
+		 * Reload the package from disk, discarding any unsaved changes that were made to the package. Does nothing if the package is not loaded or has no on-disk representation.
+		 * Only resources that changed on disk are modified, and they are modified in place.
+		 */
 		void ReloadPackage(StringID name);
 
+		/**
+		 * Start watching the content directory for packages that are changed outside of the engine. Loaded packages that change are read again in the background,
+		 * then reloaded when ApplyReloads is called. Packages with unsaved changes are not reloaded, so those changes are not lost.
+		 */
+		void StartWatching();
+		/** Stop watching the content directory. Packages that were already read in the background can still be reloaded. */
+		void StopWatching();
+		/**
+		 * Reload packages that were changed on disk and read in the background. Resources are modified in place, so this should be called regularly
+		 * from the thread that uses them, such as once per frame. Returns the number of packages that were reloaded.
+		 */
+		size_t ApplyReloads();
+
 		/**
 		 * Delete the on-disk representation for a package.
 		 * If the package is loaded, this will not affect the actual package, but after calling this the package cannot be loaded again until it is recreated.
@@ -37,11 +59,44 @@ namespace Resources {
 
 	protected:
 		virtual bool CanCreatePackage(StringID name) const override final;
-		virtual bool SavePackage(Package const& package) override final;
+		virtual size_t EstimatePackageSourceSize(StringID name) const override final;
+		virtual void SavePackageContents(StringID name, Package::ContentsContainerType const& contents, std::atomic<float>& progress) override final;
 		virtual PackageInput LoadPackageSource(StringID name) override final;
 
 	private:
+		/** Packages that were changed on disk, which are shared between the watcher and the thread that reads them again */
+		struct PendingReloads {
+			/** Packages that were changed and are waiting to be read, with the time of the most recent change */
+			std::unordered_map<StringID, std::chrono::steady_clock::time_point> changed;
+			/** Packages that were read again and are waiting to be applied */
+			std::vector<std::pair<StringID, PackageInput>> ready;
+		};
+
+		/** The time to wait after a package file changes before it is read, since programs often write files with several separate operations */
+		static constexpr std::chrono::milliseconds ReloadDelay{ 200 };
+
+		std::unique_ptr<HAL::FileWatcher> watcher;
+		std::jthread reload_thread;
+		TriggeredThreadSafe<PendingReloads> ts_reloads;
+		/** The write time of each package file that was saved by this database, so that saving does not cause packages to be reloaded */
+		ThreadSafe<std::unordered_map<StringID, std::filesystem::file_time_type>> ts_saved_times;
+
+		/** Called from the watcher thread when a file in the content directory is changed */
+		void OnFileChanged(std::filesystem::path const& path);
+		/** Read the sources of changed packages until the token is stopped. Runs on the reload thread. */
+		void ReadChangedPackages(std::stop_token token);
+		/** Reload a package using a source that was read in the background. Returns true if the package was reloaded. */
+		bool ApplyReload(StringID name, PackageInput& source);
+
+		/** Get the directory that contains all package files */
+		static std::filesystem::path GetContentDirectory();
+		/** Convert the path of a package file to the name of the package. Returns nothing if the path is not a package file. */
+		static std::optional<StringID> GetPackageName(std::filesystem::path const& path);
 		/** Convert a package name to a filesystem path where the package can be found */
 		static std::filesystem::path GetPath(StringID name);
+		/** Convert a package name to a filesystem path where a binary version of the package can be found */
+		static std::filesystem::path GetBinaryPath(StringID name);
+		/** Returns true if the binary version of a package exists and is not older than the editable version */
+		static bool ShouldLoadBinary(StringID name);
 	};
 }
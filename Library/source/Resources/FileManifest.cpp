@@ -0,0 +1,313 @@
+#include "Resources/FileManifest.h"
+#include "Engine/Archive.h"
+#include "Engine/Array.h"
+#include "Engine/Ranges.h"
+#include "HAL/MappedFile.h"
+#include "Resources/PackageIO.h"
+#include "yaml-cpp/yaml.h"
+
+namespace Resources {
+	/** Identifies a manifest index file. Reads as "ANMF" when viewed as bytes. */
+	constexpr uint32_t ManifestMagic = 0x464D4E41;
+	/** The version of the manifest index format. Indices with a different version are discarded and rebuilt. */
+	constexpr uint32_t ManifestVersion = 1;
+
+	/** Reads the data for a resource directly from the package file that contains it */
+	struct FileResourceBuffer : public IResourceBuffer {
+		FileResourceBuffer(std::filesystem::path path, StringID name, EPackageSourceType source, ManifestResourceEntry const& entry)
+			: path(std::move(path)), name(name), source(source), offset(entry.offset), size(entry.size), codec(entry.codec), uncompressed_size(entry.uncompressed_size)
+		{}
+
+		virtual void Load(std::vector<uint8_t>& buffer) override final {
+			if (source == EPackageSourceType::Binary) {
+				HAL::MappedFile const file{ path };
+				std::span<std::byte const> const bytes = file.GetBytes();
+				if (offset > bytes.size() || size > bytes.size() - offset) throw FormatType<std::runtime_error>("Resource {} is outside the bounds of file '{}', the manifest is out of date", name, path.generic_string());
+
+				buffer.resize(uncompressed_size);
+				Compression::Decompress(codec, bytes.subspan(offset, size), std::as_writable_bytes(std::span{ buffer }));
+
+			} else {
+				//Resources in YAML packages cannot be located without parsing the package, so the resource is emitted on its own
+				std::ifstream file{ path, std::ios_base::in };
+				PackageInput_YAML input{ file };
+
+				for (auto const& [id, type, node] : input.GetContentsInformation()) {
+					if (id != name) continue;
+
+					YAML::Emitter emitter;
+					emitter << node;
+					std::string_view const text{ emitter.c_str(), emitter.size() };
+
+					buffer.assign(text.begin(), text.end());
+					return;
+				}
+				throw FormatType<std::runtime_error>("Resource {} was not found in file '{}', the manifest is out of date", name, path.generic_string());
+			}
+		}
+
+		virtual void Save(std::vector<uint8_t> const& buffer) override final {
+			throw FormatType<std::runtime_error>("Resource {} cannot be saved on its own, the package that contains it must be saved instead", name);
+		}
+
+	private:
+		std::filesystem::path path;
+		StringID name;
+		EPackageSourceType source;
+		size_t offset;
+		size_t size;
+		Compression::CodecID codec;
+		size_t uncompressed_size;
+	};
+
+	FileManifest::FileManifest(std::filesystem::path directory)
+		: directory(std::move(directory))
+	{
+		Load();
+		Refresh();
+	}
+
+	PersistentInfo const* FileManifest::GetInfo(Identifier id) const {
+		if (ManifestResourceEntry const* entry = FindResource(id)) return &entry->info;
+		else return nullptr;
+	}
+
+	std::shared_ptr<IResourceBuffer> FileManifest::Open(Identifier id) {
+		ManifestPackageEntry const* package = FindPackage(id.package);
+		if (!package) return nullptr;
+
+		auto const iter = package->resources.find(id.resource);
+		if (iter == package->resources.end()) return nullptr;
+
+		return std::make_shared<FileResourceBuffer>(GetPackagePath(id.package, package->source), id.resource, package->source, iter->second);
+	}
+
+	bool FileManifest::Refresh() {
+		struct PackageFiles {
+			std::optional<int64_t> yaml_time;
+			std::optional<int64_t> binary_time;
+		};
+
+		//Find all the package files that currently exist in the directory
+		std::unordered_map<StringID, PackageFiles> files;
+		std::error_code error;
+		for (auto iter = std::filesystem::recursive_directory_iterator{ directory, error }; !error && iter != std::filesystem::recursive_directory_iterator{}; iter.increment(error)) {
+			if (!iter->is_regular_file()) continue;
+
+			std::filesystem::path const& path = iter->path();
+			std::filesystem::path const extension = path.extension();
+			bool const is_yaml = extension == ".yaml"sv;
+			bool const is_binary = extension == ".bin"sv;
+			if (!is_yaml && !is_binary) continue;
+
+			std::string const name = std::filesystem::path{ path }.replace_extension().lexically_relative(directory).generic_string();
+			int64_t const time = iter->last_write_time().time_since_epoch().count();
+
+			PackageFiles& package_files = files[StringID{ name }];
+			(is_yaml ? package_files.yaml_time : package_files.binary_time) = time;
+		}
+
+		bool changed = false;
+
+		//Packages which no longer have any files are removed
+		changed |= std::erase_if(packages, [&](auto const& pair) { return !files.contains(pair.first); }) > 0;
+
+		for (auto const& [name, package_files] : files) {
+			//Binary packages are preferred as long as they are not older than the editable version, matching the way packages are loaded
+			bool const use_binary = package_files.binary_time && (!package_files.yaml_time || *package_files.binary_time >= *package_files.yaml_time);
+			EPackageSourceType const source = use_binary ? EPackageSourceType::Binary : EPackageSourceType::YAML;
+			int64_t const time = use_binary ? *package_files.binary_time : *package_files.yaml_time;
+
+			auto const iter = packages.find(name);
+			if (iter != packages.end() && iter->second.source == source && iter->second.last_write_time == time) continue;
+
+			changed = true;
+			try {
+				packages.insert_or_assign(name, IndexPackage(GetPackagePath(name, source), source, time));
+			} catch (std::exception const& e) {
+				LOG(Resources, Warning, "Unable to index package {}, it will be excluded from the manifest: {}", name, e.what());
+				packages.erase(name);
+			}
+		}
+
+		if (changed) {
+			RebuildLookups();
+
+			//The manifest can still be used if the index cannot be saved, it will just need to index the same packages again next time
+			try {
+				Save();
+			} catch (std::exception const& e) {
+				LOG(Resources, Warning, "Unable to save manifest index: {}", e.what());
+			}
+		}
+		return changed;
+	}
+
+	ManifestPackageEntry const* FileManifest::FindPackage(StringID package) const {
+		auto const iter = packages.find(package);
+		if (iter != packages.end()) return &iter->second;
+		else return nullptr;
+	}
+
+	ManifestResourceEntry const* FileManifest::FindResource(Identifier id) const {
+		if (ManifestPackageEntry const* package = FindPackage(id.package)) {
+			auto const iter = package->resources.find(id.resource);
+			if (iter != package->resources.end()) return &iter->second;
+		}
+		return nullptr;
+	}
+
+	std::span<StringID const> FileManifest::FindPackagesContaining(StringID resource) const {
+		auto const iter = resource_packages.find(resource);
+		if (iter != resource_packages.end()) return iter->second;
+		else return {};
+	}
+
+	std::span<StringID const> FileManifest::FindDependents(StringID package) const {
+		auto const iter = dependents.find(package);
+		if (iter != dependents.end()) return iter->second;
+		else return {};
+	}
+
+	std::filesystem::path FileManifest::GetIndexPath() const {
+		return directory / "manifest.index"sv;
+	}
+
+	std::filesystem::path FileManifest::GetPackagePath(StringID package, EPackageSourceType source) const {
+		return directory / std::filesystem::path{ package.ToStringView() }.replace_extension(source == EPackageSourceType::Binary ? "bin"sv : "yaml"sv);
+	}
+
+	void FileManifest::Load() {
+		packages.clear();
+
+		std::filesystem::path const path = GetIndexPath();
+		if (!std::filesystem::exists(path)) return;
+
+		try {
+			HAL::MappedFile const file{ path };
+			Archive::Input archive{ file.GetBytes() };
+
+			uint32_t magic = 0;
+			uint32_t version = 0;
+			archive >> magic >> version;
+			if (magic != ManifestMagic || version != ManifestVersion) throw std::runtime_error{ "File is not a manifest index with a supported version" };
+
+			size_t num_packages = 0;
+			archive >> num_packages;
+			packages.reserve(num_packages);
+
+			for (size_t package_index = 0; package_index < num_packages; ++package_index) {
+				StringID name = StringID::None;
+				uint8_t source = 0;
+				ManifestPackageEntry package;
+				size_t num_resources = 0;
+
+				archive >> name >> source >> package.last_write_time >> package.dependencies >> num_resources;
+				package.source = static_cast<EPackageSourceType>(source);
+				package.resources.reserve(num_resources);
+
+				for (size_t resource_index = 0; resource_index < num_resources; ++resource_index) {
+					StringID resource_name = StringID::None;
+					ManifestResourceEntry resource;
+
+					archive >> resource_name >> resource.type >> resource.offset >> resource.size >> resource.codec >> resource.uncompressed_size;
+					archive >> resource.info.name >> resource.info.flags >> resource.info.metadata;
+
+					package.resources.emplace(resource_name, std::move(resource));
+				}
+
+				packages.emplace(name, std::move(package));
+			}
+
+		} catch (std::exception const& e) {
+			LOG(Resources, Warning, "Unable to read manifest index '{}', it will be rebuilt: {}", path.generic_string(), e.what());
+			packages.clear();
+		}
+
+		RebuildLookups();
+	}
+
+	void FileManifest::Save() const {
+		std::vector<std::byte> bytes;
+		Archive::Output archive{ bytes };
+
+		archive << ManifestMagic << ManifestVersion << packages.size();
+		for (auto const& [name, package] : packages) {
+			archive << name << std::to_underlying(package.source) << package.last_write_time << package.dependencies << package.resources.size();
+
+			for (auto const& [resource_name, resource] : package.resources) {
+				archive << resource_name << resource.type << resource.offset << resource.size << resource.codec << resource.uncompressed_size;
+				archive << resource.info.name << resource.info.flags << resource.info.metadata;
+			}
+		}
+
+		std::filesystem::path const path = GetIndexPath();
+		std::filesystem::path temporary_path = path;
+		temporary_path += ".tmp"sv;
+
+		//Write to a temporary file first, so readers never see a partially written index
+		{
+			std::ofstream file{ temporary_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary };
+			if (!file.is_open() || !file.good()) throw FormatType<std::runtime_error>("Unable to open file '{}' to save manifest index", temporary_path.generic_string());
+
+			std::span<char const> const characters = stdext::from_bytes<char>(bytes);
+			file.write(characters.data(), characters.size());
+			file.close();
+			if (file.fail()) throw FormatType<std::runtime_error>("Unable to write file '{}' to save manifest index", temporary_path.generic_string());
+		}
+
+		std::filesystem::rename(temporary_path, path);
+	}
+
+	void FileManifest::RebuildLookups() {
+		resource_packages.clear();
+		dependents.clear();
+
+		for (auto const& [name, package] : packages) {
+			for (auto const& pair : package.resources) resource_packages[pair.first].emplace_back(name);
+			for (StringID const dependency : package.dependencies) dependents[dependency].emplace_back(name);
+		}
+	}
+
+	ManifestPackageEntry FileManifest::IndexPackage(std::filesystem::path const& path, EPackageSourceType source, int64_t last_write_time) {
+		ManifestPackageEntry package;
+		package.source = source;
+		package.last_write_time = last_write_time;
+
+		const auto AddResource = [&](StringID name, Reflection::TypeInfoReference const& type) -> ManifestResourceEntry& {
+			ManifestResourceEntry& resource = package.resources[name];
+			resource.info.name = name.ToStringView();
+			resource.info.flags = 0;
+			resource.type = type;
+			return resource;
+		};
+
+		if (source == EPackageSourceType::Binary) {
+			//Only the index of the package is read, the data for each resource is left untouched in the mapped file
+			PackageInput_Binary const input{ path };
+
+			auto const dependencies = input.GetDependencies();
+			package.dependencies.assign(dependencies.begin(), dependencies.end());
+
+			for (auto const& [name, type, data] : input.GetContentsInformation()) {
+				ManifestResourceEntry& resource = AddResource(name, type);
+				resource.offset = data.bytes.data() - input.bytes.data();
+				resource.size = data.bytes.size();
+				resource.codec = data.codec;
+				resource.uncompressed_size = data.uncompressed_size;
+			}
+
+		} else {
+			std::ifstream file{ path, std::ios_base::in };
+			if (!file.is_open()) throw FormatType<std::runtime_error>("Unable to open file '{}'", path.generic_string());
+			PackageInput_YAML input{ file };
+
+			auto const dependencies = input.GetDependencies();
+			package.dependencies.assign(dependencies.begin(), dependencies.end());
+
+			for (auto const& [name, type, node] : input.GetContentsInformation()) AddResource(name, type);
+		}
+
+		return package;
+	}
+}
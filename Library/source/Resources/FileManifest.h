@@ -0,0 +1,85 @@
+#pragma once
+#include "Engine/Compression.h"
+#include "Engine/Core.h"
+#include "Engine/Reflection.h"
+#include "Engine/StringID.h"
+#include "Resources/Manifest.h"
+
+namespace Resources {
+	/** The kind of file that a package is loaded from */
+	enum class EPackageSourceType : uint8_t {
+		YAML,
+		Binary,
+	};
+
+	/** Information about a resource which is recorded in a manifest */
+	struct ManifestResourceEntry {
+		PersistentInfo info;
+		/** The type of the resource */
+		Reflection::TypeInfoReference type;
+		/** The range of bytes within the package file that contains the resource. Empty for packages which are not binary. */
+		size_t offset = 0;
+		size_t size = 0;
+		/** The codec used to compress the bytes of the resource */
+		Compression::CodecID codec = Compression::NoCodec;
+		/** The size of the bytes of the resource once they are decompressed */
+		size_t uncompressed_size = 0;
+	};
+
+	/** Information about a package which is recorded in a manifest */
+	struct ManifestPackageEntry {
+		/** The kind of file that the package is loaded from */
+		EPackageSourceType source = EPackageSourceType::YAML;
+		/** The time when the package file was last written when it was indexed. Packages are indexed again when this changes. */
+		int64_t last_write_time = 0;
+		/** The packages that contain resources referenced by this package */
+		std::vector<StringID> dependencies;
+		/** The resources contained in this package */
+		std::unordered_map<StringID, ManifestResourceEntry> resources;
+	};
+
+	/**
+	 * Indexes all packages in a directory, so information about packages and resources can be found without opening every package.
+	 * The index is stored in a single file within the directory, and is updated incrementally by reading only packages whose files have changed.
+	 * Queries may be performed from multiple threads, but not while the manifest is being refreshed.
+	 */
+	struct FileManifest : public IManifest {
+		/** Load the index for the directory, then refresh it to match the packages in the directory */
+		FileManifest(std::filesystem::path directory);
+
+		virtual PersistentInfo const* GetInfo(Identifier id) const override final;
+		virtual std::shared_ptr<IResourceBuffer> Open(Identifier id) override final;
+
+		/** Index packages that were added or changed since the last refresh, and remove packages that no longer exist. Saves the index if it changed. */
+		bool Refresh();
+
+		/** Find the information for a package. Returns nullptr if the package does not exist. */
+		ManifestPackageEntry const* FindPackage(StringID package) const;
+		/** Find the information for a resource. Returns nullptr if the resource does not exist. */
+		ManifestResourceEntry const* FindResource(Identifier id) const;
+		/** Find all packages that contain a resource with the name */
+		std::span<StringID const> FindPackagesContaining(StringID resource) const;
+		/** Find all packages that directly depend on the package */
+		std::span<StringID const> FindDependents(StringID package) const;
+
+	private:
+		std::filesystem::path directory;
+		std::unordered_map<StringID, ManifestPackageEntry> packages;
+
+		/** Lookups that are derived from the package entries, rebuilt whenever they change */
+		std::unordered_map<StringID, std::vector<StringID>> resource_packages;
+		std::unordered_map<StringID, std::vector<StringID>> dependents;
+
+		std::filesystem::path GetIndexPath() const;
+		std::filesystem::path GetPackagePath(StringID package, EPackageSourceType source) const;
+
+		/** Read the index file, if it exists. An index which cannot be read is discarded, and will be rebuilt by the next refresh. */
+		void Load();
+		/** Write the index file */
+		void Save() const;
+		void RebuildLookups();
+
+		/** Read a package file to create a new entry for it */
+		static ManifestPackageEntry IndexPackage(std::filesystem::path const& path, EPackageSourceType source, int64_t last_write_time);
+	};
+}
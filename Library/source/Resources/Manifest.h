@@ -1,9 +1,11 @@
 #pragma once
-#include "Engine/StandardTypes.h"
+#include "Engine/Core.h"
+#include "Engine/Hash.h"
+#include "Engine/Map.h"
+#include "Engine/SmartPointers.h"
+#include "Engine/String.h"
 #include "Resources/ResourceTypes.h"
 
-//EXPERIMENTAL, UNDER CONSTRUCTION
-
 namespace Resources {
 	/** Persistent info about a resource which can be queried without loading the real resource */
 	struct PersistentInfo {
@@ -0,0 +1,139 @@
+#include "Resources/PackageArchive.h"
+#include "Engine/Archive.h"
+#include "Engine/Ranges.h"
+
+namespace Resources {
+	//=================================================================================
+	//Package archive format is as follows, where the elements in the file are specified as [Name:Size]:
+	//[Magic:sizeof(uint32_t)][Version:sizeof(uint32_t)][DirectoryOffset:sizeof(size_t)][DirectorySize:sizeof(size_t)]
+	//[PackageA:...][Padding][PackageB:...][Padding]...
+	//[Directory:DirectorySize]
+	//
+	//The directory is written after the packages, so packages can be written without knowing the size of the directory. The directory is as follows:
+	//[PackageCount:sizeof(size_t)]
+	//[PackageAName:sizeof(StringID)][PackageASource:sizeof(uint8_t)][PackageAOffset:sizeof(size_t)][PackageASize:sizeof(size_t)]
+	//...
+	//Each package starts at an offset that is a multiple of the alignment, and contains the same bytes as the file that the package was cooked from.
+
+	PackageArchiveOutput::PackageArchiveOutput(std::filesystem::path path, size_t alignment)
+		: path(std::move(path)), alignment(std::max<size_t>(alignment, 1))
+	{
+		temporary_path = this->path;
+		temporary_path += ".tmp"sv;
+
+		//Write to a temporary file first, so readers never see a partially written archive
+		file.open(temporary_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+		if (!file.is_open() || !file.good()) throw FormatType<std::runtime_error>("Unable to open file '{}' to write package archive", temporary_path.generic_string());
+
+		//The header is written again once the location of the directory is known
+		Write(SerializeHeader(0, 0));
+	}
+
+	PackageArchiveOutput::~PackageArchiveOutput() {
+		if (file.is_open()) {
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(temporary_path, error);
+		}
+	}
+
+	void PackageArchiveOutput::Add(StringID name, EPackageSourceType source, std::span<std::byte const> bytes) {
+		if (!file.is_open()) throw FormatType<std::runtime_error>("Cannot add package {} to archive '{}', the archive is already finished", name, path.generic_string());
+		if (!names.insert(name).second) throw FormatType<std::runtime_error>("Package {} was already added to archive '{}'", name, path.generic_string());
+
+		size_t const padding = (alignment - (position % alignment)) % alignment;
+		if (padding > 0) Write(std::vector<std::byte>(padding, std::byte{ 0 }));
+
+		entries.emplace_back(PackageArchiveEntry{ name, source, position, bytes.size() });
+		Write(bytes);
+	}
+
+	void PackageArchiveOutput::Finish() {
+		if (!file.is_open()) throw FormatType<std::runtime_error>("Archive '{}' is already finished", path.generic_string());
+
+		std::vector<std::byte> directory;
+		{
+			Archive::Output archive{ directory };
+			archive << entries.size();
+			for (PackageArchiveEntry const& entry : entries) {
+				archive << entry.name << std::to_underlying(entry.source) << entry.offset << entry.size;
+			}
+		}
+
+		size_t const directory_offset = position;
+		Write(directory);
+
+		file.seekp(0);
+		Write(SerializeHeader(directory_offset, directory.size()));
+
+		file.close();
+		if (file.fail()) throw FormatType<std::runtime_error>("Unable to write file '{}' to save package archive", temporary_path.generic_string());
+
+		std::filesystem::rename(temporary_path, path);
+	}
+
+	void PackageArchiveOutput::Write(std::span<std::byte const> bytes) {
+		std::span<char const> const characters = stdext::from_bytes<char>(bytes);
+		file.write(characters.data(), characters.size());
+		if (file.fail()) throw FormatType<std::runtime_error>("Unable to write file '{}' to save package archive", temporary_path.generic_string());
+
+		position += bytes.size();
+	}
+
+	std::vector<std::byte> PackageArchiveOutput::SerializeHeader(size_t directory_offset, size_t directory_size) {
+		std::vector<std::byte> bytes;
+		Archive::Output archive{ bytes };
+		archive << PackageArchiveMagic << PackageArchiveVersion << directory_offset << directory_size;
+		return bytes;
+	}
+
+	PackageArchiveInput::PackageArchiveInput(std::filesystem::path const& path)
+		: path(path), file(std::make_shared<HAL::MappedFile const>(path))
+	{
+		std::span<std::byte const> const bytes = file->GetBytes();
+		Archive::Input header{ bytes };
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		size_t directory_offset = 0;
+		size_t directory_size = 0;
+		header >> magic >> version >> directory_offset >> directory_size;
+		if (magic != PackageArchiveMagic || version != PackageArchiveVersion) throw FormatType<std::runtime_error>("File '{}' is not a package archive with a supported version", path.generic_string());
+		if (directory_offset > bytes.size() || directory_size > bytes.size() - directory_offset) throw FormatType<std::runtime_error>("Directory of package archive '{}' is outside the bounds of the file", path.generic_string());
+
+		Archive::Input directory{ bytes.subspan(directory_offset, directory_size) };
+
+		size_t num_packages = 0;
+		directory >> num_packages;
+		entries.reserve(num_packages);
+		lookup.reserve(num_packages);
+
+		for (size_t index = 0; index < num_packages; ++index) {
+			PackageArchiveEntry entry;
+			uint8_t source = 0;
+			directory >> entry.name >> source >> entry.offset >> entry.size;
+			entry.source = static_cast<EPackageSourceType>(source);
+
+			if (entry.offset > directory_offset || entry.size > directory_offset - entry.offset) throw FormatType<std::runtime_error>("Package {} is outside the bounds of package archive '{}'", entry.name, path.generic_string());
+
+			lookup.emplace(entry.name, entries.size());
+			entries.emplace_back(entry);
+		}
+	}
+
+	PackageArchiveEntry const* PackageArchiveInput::Find(StringID name) const {
+		auto const iter = lookup.find(name);
+		if (iter != lookup.end()) return &entries[iter->second];
+		else return nullptr;
+	}
+
+	PackageInput PackageArchiveInput::Open(PackageArchiveEntry const& entry) const {
+		std::span<std::byte const> const bytes = file->GetBytes().subspan(entry.offset, entry.size);
+
+		//Binary packages keep the archive mapped, so the data for each resource points directly into the archive
+		if (entry.source == EPackageSourceType::Binary) return PackageInput_Binary{ file, bytes };
+
+		std::span<char const> const characters = stdext::from_bytes<char>(bytes);
+		return PackageInput_YAML{ std::string{ characters.begin(), characters.end() } };
+	}
+}
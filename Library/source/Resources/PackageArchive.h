@@ -0,0 +1,82 @@
+#pragma once
+#include "Engine/Core.h"
+#include "Engine/Map.h"
+#include "Engine/Set.h"
+#include "Engine/SmartPointers.h"
+#include "Engine/StringID.h"
+#include "HAL/MappedFile.h"
+#include "Resources/FileManifest.h"
+#include "Resources/PackageIO.h"
+
+namespace Resources {
+	/** Identifies a package archive. Reads as "ANPA" when viewed as bytes. */
+	constexpr uint32_t PackageArchiveMagic = 0x41504E41;
+	/** The version of the package archive format */
+	constexpr uint32_t PackageArchiveVersion = 1;
+
+	/** The location of a package within a package archive */
+	struct PackageArchiveEntry {
+		StringID name = StringID::None;
+		/** The format of the package bytes, which are the same as the file that the package was cooked from */
+		EPackageSourceType source = EPackageSourceType::Binary;
+		/** The range of bytes within the archive that contains the package */
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	/**
+	 * Writes packages into a single archive file, followed by a directory that locates each package.
+	 * Packages are placed in the order they are added, so packages that are loaded together should be added together.
+	 */
+	struct PackageArchiveOutput {
+		/** The default alignment of each package within the archive */
+		static constexpr size_t DefaultAlignment = 16;
+
+		/** Start writing an archive. The archive is written to a temporary file, and does not replace the file at the path until it is finished. */
+		PackageArchiveOutput(std::filesystem::path path, size_t alignment = DefaultAlignment);
+		PackageArchiveOutput(PackageArchiveOutput const&) = delete;
+		PackageArchiveOutput(PackageArchiveOutput&&) = delete;
+		/** Removes the temporary file if the archive was not finished */
+		~PackageArchiveOutput();
+
+		/** Append a package to the archive. Each package may only be added once. */
+		void Add(StringID name, EPackageSourceType source, std::span<std::byte const> bytes);
+		/** Write the directory and replace the file at the path with the finished archive. No more packages can be added. */
+		void Finish();
+
+	private:
+		std::filesystem::path path;
+		std::filesystem::path temporary_path;
+		size_t alignment;
+		std::ofstream file;
+		size_t position = 0;
+		std::vector<PackageArchiveEntry> entries;
+		std::unordered_set<StringID> names;
+
+		void Write(std::span<std::byte const> bytes);
+		/** The header at the start of the archive, which locates the directory */
+		static std::vector<std::byte> SerializeHeader(size_t directory_offset, size_t directory_size);
+	};
+
+	/**
+	 * Reads packages from an archive file. The archive is mapped into memory once, and binary packages are read directly from the mapped file.
+	 * The directory is not modified after the archive is opened, so packages can be found and opened from multiple threads.
+	 */
+	struct PackageArchiveInput {
+		PackageArchiveInput(std::filesystem::path const& path);
+
+		/** Get the entries for all packages, in the order they are placed within the archive */
+		inline std::span<PackageArchiveEntry const> GetEntries() const { return entries; }
+		/** Find the entry for a package. Returns nullptr if the archive does not contain the package. */
+		PackageArchiveEntry const* Find(StringID name) const;
+		/** Open a package that is contained in the archive */
+		PackageInput Open(PackageArchiveEntry const& entry) const;
+
+	private:
+		std::filesystem::path path;
+		std::shared_ptr<HAL::MappedFile const> file;
+		std::vector<PackageArchiveEntry> entries;
+		/** The index of the entry for each package */
+		std::unordered_map<StringID, size_t> lookup;
+	};
+}
@@ -1,24 +1,55 @@
 #include "Resources/PackageIO.h"
 #include "Engine/Core.h"
+#include "Engine/Optional.h"
 #include "Resources/Package.h"
 #include "Resources/Streaming.h"
 #include "Resources/StreamingUtils.h"
+#include "yaml-cpp/eventhandler.h"
+#include <spanstream>
 
 namespace Resources {
 	//=================================================================================
 	//Binary package format is as follows, where the elements in the buffer are specified as [Name:Size]:
+	//[Magic:sizeof(uint32_t)][Version:sizeof(uint32_t)]
 	//[DependencyCount:sizeof(size_t)][Dependencies:DependencyCount]
+	//[ResourceCount:sizeof(size_t)]
+	//[ResourceAName:sizeof(StringID)][ResourceAType:sizeof(TypeInfoReference)][ResourceACodec:sizeof(CodecID)][ResourceAOffset:sizeof(size_t)][ResourceASize:sizeof(size_t)][ResourceAUncompressedSize:sizeof(size_t)]
+	//[ResourceBName:sizeof(StringID)][ResourceBType:sizeof(TypeInfoReference)][ResourceBCodec:sizeof(CodecID)][ResourceBOffset:sizeof(size_t)][ResourceBSize:sizeof(size_t)][ResourceBUncompressedSize:sizeof(size_t)]
+	//...
+	//[Payload:...]
+	//Resource offsets are relative to the start of the payload, which immediately follows the table of contents.
+	//Indexed packages (version 1) do not contain the codec or uncompressed size, and all resources are uncompressed.
+	//
+	//Legacy packages have no header, and each resource's data immediately follows its name and type:
+	//[DependencyCount:sizeof(size_t)][Dependencies:DependencyCount]
+	//[ResourceCount:sizeof(size_t)]
 	//[ResourceAName:sizeof(StringID)][ResourceAType:sizeof(TypeInfoReference)][ResourceADataSize:sizeof(size_t)][ResourceAData:ResourceADataSize]
-	//[ResourceBName:sizeof(StringID)][ResourceBType:sizeof(TypeInfoReference)][ResourceBDataSize:sizeof(size_t)][ResourceBData:ResourceBDataSize]
 	//...
 
-	PackageOutput_Binary::PackageOutput_Binary(Package const& package) {
+	std::span<std::byte const> BinaryResourceData::Decompress(std::vector<std::byte>& buffer) const {
+		if (codec == Compression::NoCodec) return bytes;
+
+		//The uncompressed size is read from the package, so it is checked before allocating memory for it
+		if (uncompressed_size / MaxCompressionRatio > bytes.size()) {
+			throw FormatType<std::runtime_error>("Uncompressed size {} is too large for {} bytes of compressed data", uncompressed_size, bytes.size());
+		}
+
+		buffer.resize(uncompressed_size);
+		Compression::Decompress(codec, bytes, buffer);
+		return buffer;
+	}
+
+	//Copy the contents, then serialize. This means further changes during serialization will not be included, but avoids locking the package for a long duration.
+	PackageOutput_Binary::PackageOutput_Binary(Package const& package, BinaryPackageSettings const& settings)
+		: PackageOutput_Binary(*package.GetContentsView(), settings)
+	{}
+
+	PackageOutput_Binary::PackageOutput_Binary(Package::ContentsContainerType const& contents, BinaryPackageSettings const& settings) {
 		Archive::Output archive{ bytes };
 
-		//Copy the contents, then serialize. This means further changes during serialization will not be included, but avoids locking the package for a long duration.
-		auto const contents = *package.GetContentsView();
+		archive << BinaryPackageMagic << std::to_underlying(EBinaryPackageVersion::Current);
 		SerializeDependencies(archive, contents);
-		SerializeContents(archive, contents);
+		SerializeContents(archive, contents, settings);
 	}
 
 	void PackageOutput_Binary::Write(std::ostream& stream) const {
@@ -31,59 +62,145 @@ namespace Resources {
 		archive << dependencies;
 	}
 
-	void PackageOutput_Binary::SerializeContents(Archive::Output& archive, Package::ContentsContainerType const& contents) {
+	void PackageOutput_Binary::SerializeContents(Archive::Output& archive, Package::ContentsContainerType const& contents, BinaryPackageSettings const& settings) {
 		archive << contents.size();
 
-		std::vector<std::byte> resource_bytes;
+		//Resources are serialized into the payload first, so the table of contents can record where each one is located
+		std::vector<std::byte> payload;
+		Archive::Output payload_archive{ payload };
+		std::vector<std::byte> uncompressed;
 		for (auto const& pair : contents) {
 			StringID const name = pair.first;
 			Resources::Resource const& resource = *pair.second;
 
 			Reflection::StructTypeInfo const& type = resource.GetTypeInfo();
-			{
-				//@todo We don't need a temporary vector here if we can write a "section" to the output, where the size is written before the bytes following it.
-				resource_bytes.clear();
-				Archive::Output resource_archive{ resource_bytes };
-				type.Serialize(resource_archive, &resource);
+
+			size_t const offset = payload.size();
+			type.Serialize(payload_archive, &resource);
+			size_t const uncompressed_size = payload.size() - offset;
+
+			//Codecs cannot compress in place, so only resources that will be compressed are copied out of the payload
+			Compression::CodecID used_codec = Compression::NoCodec;
+			if (settings.codec != Compression::NoCodec && uncompressed_size >= settings.min_compressed_size) {
+				uncompressed.assign(payload.begin() + offset, payload.end());
+				Archive::Rewind(payload_archive, offset);
+				used_codec = Compression::Compress(settings.codec, uncompressed, payload);
 			}
 
-			archive << name << Reflection::TypeInfoReference{ type } << resource_bytes;
+			archive << name << Reflection::TypeInfoReference{ type } << used_codec << offset << (payload.size() - offset) << uncompressed_size;
 		}
+
+		WriteBytes(archive, payload);
+	}
+
+	std::vector<std::byte> PackageInput_Binary::ExtractAllBytes(std::istream& stream) {
+		std::vector<std::byte> bytes;
+		ExtractBytes(stream, std::back_inserter(bytes));
+		return bytes;
 	}
 
 	PackageInput_Binary::PackageInput_Binary(std::istream& stream)
-		: archive(bytes)
+		: storage(std::in_place_type<std::vector<std::byte>>, ExtractAllBytes(stream))
+		, bytes(std::get<std::vector<std::byte>>(storage))
 	{
-		ExtractBytes(stream, std::back_inserter(bytes));
+		ReadIndex();
 	}
 
-	std::unordered_set<StringID> PackageInput_Binary::GetDependencies() {
-		std::unordered_set<StringID> packages;
-		archive >> packages;
+	PackageInput_Binary::PackageInput_Binary(std::filesystem::path const& path)
+		: storage(std::in_place_type<HAL::MappedFile>, path)
+		, bytes(std::get<HAL::MappedFile>(storage).GetBytes())
+	{
+		ReadIndex();
+	}
 
-		packages.erase(StringID::None);
-		packages.erase(StringID::Temporary);
+	PackageInput_Binary::PackageInput_Binary(std::shared_ptr<HAL::MappedFile const> file, std::span<std::byte const> bytes)
+		: storage(std::in_place_type<std::shared_ptr<HAL::MappedFile const>>, std::move(file))
+		, bytes(bytes)
+	{
+		ReadIndex();
+	}
 
-		return packages;
+	std::unordered_set<StringID> PackageInput_Binary::GetDependencies() const {
+		return dependencies;
 	}
 
-	std::vector<PackageInput_Binary::InfoTuple> PackageInput_Binary::GetContentsInformation() {
-		size_t count = 0;
-		archive >> count;
+	std::vector<PackageInput_Binary::InfoTuple> PackageInput_Binary::GetContentsInformation() const {
+		return contents;
+	}
 
-		std::vector<InfoTuple> results;
-		results.reserve(count);
+	void PackageInput_Binary::ReadIndex() {
+		Archive::Input archive{ bytes };
 
-		for (size_t index = 0; index < count; ++index) {
-			StringID id = StringID::None;
-			Reflection::TypeInfoReference type_reference;
-			std::span<std::byte const> buffer;
+		//Legacy packages begin with the number of dependencies, which will never match the magic value in practice
+		uint32_t magic = 0;
+		if (bytes.size() >= sizeof(magic)) {
+			Archive::Input header = archive;
+			header >> magic;
+		}
 
-			archive >> id >> type_reference >> buffer;
-			results.emplace_back(id, type_reference, buffer);
+		if (magic == BinaryPackageMagic) {
+			uint32_t version_number = 0;
+			archive >> magic >> version_number;
+
+			if (version_number > std::to_underlying(EBinaryPackageVersion::Current)) {
+				throw FormatType<std::runtime_error>("Binary package version {} is newer than the latest supported version {}", version_number, std::to_underlying(EBinaryPackageVersion::Current));
+			}
+			version = static_cast<EBinaryPackageVersion>(version_number);
+
+			size_t count = 0;
+			archive >> dependencies >> count;
+
+			bool const has_compression = version >= EBinaryPackageVersion::Compressed;
+
+			std::vector<std::tuple<StringID, Reflection::TypeInfoReference, Compression::CodecID, size_t, size_t, size_t>> entries;
+			entries.reserve(count);
+			for (size_t index = 0; index < count; ++index) {
+				StringID id = StringID::None;
+				Reflection::TypeInfoReference type_reference;
+				Compression::CodecID codec = Compression::NoCodec;
+				size_t offset = 0;
+				size_t size = 0;
+				size_t uncompressed_size = 0;
+
+				archive >> id >> type_reference;
+				if (has_compression) archive >> codec;
+				archive >> offset >> size;
+				if (has_compression) archive >> uncompressed_size;
+				else uncompressed_size = size;
+
+				entries.emplace_back(id, type_reference, codec, offset, size, uncompressed_size);
+			}
+
+			//Everything after the table of contents is the payload. The offsets are checked, since the data will be read without further bounds checks.
+			std::span<std::byte const> const payload = bytes.subspan(bytes.size() - archive.Remaining());
+
+			contents.reserve(count);
+			for (auto const& [id, type_reference, codec, offset, size, uncompressed_size] : entries) {
+				if (offset > payload.size() || size > payload.size() - offset) {
+					throw FormatType<std::runtime_error>("Resource {} is outside of the bounds of the binary package payload", id);
+				}
+				contents.emplace_back(id, type_reference, BinaryResourceData{ payload.subspan(offset, size), codec, uncompressed_size });
+			}
+
+		} else {
+			version = EBinaryPackageVersion::Legacy;
+
+			size_t count = 0;
+			archive >> dependencies >> count;
+
+			contents.reserve(count);
+			for (size_t index = 0; index < count; ++index) {
+				StringID id = StringID::None;
+				Reflection::TypeInfoReference type_reference;
+				std::span<std::byte const> buffer;
+
+				archive >> id >> type_reference >> buffer;
+				contents.emplace_back(id, type_reference, BinaryResourceData{ buffer, Compression::NoCodec, buffer.size() });
+			}
 		}
 
-		return results;
+		dependencies.erase(StringID::None);
+		dependencies.erase(StringID::Temporary);
 	}
 
 	//=================================================================================
@@ -109,11 +226,14 @@ namespace Resources {
 	static std::string_view const type_name = "type"sv;
 	static std::string_view const object_name = "object"sv;
 
+	//Copy the contents, then serialize. This means further changes during serialization will not be changed, but avoids locking the package for a long duration.
 	PackageOutput_YAML::PackageOutput_YAML(Package const& package)
+		: PackageOutput_YAML(*package.GetContentsView())
+	{}
+
+	PackageOutput_YAML::PackageOutput_YAML(Package::ContentsContainerType const& contents)
 		: root(YAML::NodeType::Map)
 	{
-		//Copy the contents, then serialize. This means further changes during serialization will not be changed, but avoids locking the package for a long duration.
-		auto const contents = *package.GetContentsView();
 		root[dependencies_name] = SerializeDependencies(contents);
 		root[contents_name] = SerializeContents(contents);
 	}
@@ -149,11 +269,135 @@ namespace Resources {
 		return sequence;
 	}
 
-	PackageInput_YAML::PackageInput_YAML(std::istream& stream)
-		: root(YAML::Load(stream))
+	/**
+	 * Builds nodes from parser events. Each resource in the contents is built as a separate node and given to the callback instead of being added to the package node,
+	 * so nodes for the whole package never exist at the same time. Aliases are copied, so resources never share memory with each other.
+	 */
+	struct PackageInput_YAML::EventReader : public YAML::EventHandler {
+		/** Thrown to stop the parser once the dependencies are read, since the parser reads the whole document otherwise */
+		struct DependenciesRead {};
+
+		YAML::Node root;
+
+		EventReader(FunctionRef<void(YAML::Node&&, size_t)> callback, bool stop_after_dependencies) : callback(callback), stop_after_dependencies(stop_after_dependencies) {}
+
+		virtual void OnDocumentStart(YAML::Mark const& mark) override { position = mark.pos; }
+		virtual void OnDocumentEnd() override {}
+
+		virtual void OnNull(YAML::Mark const& mark, YAML::anchor_t anchor) override {
+			position = mark.pos;
+			Add(YAML::Node{ YAML::NodeType::Null }, anchor);
+		}
+		virtual void OnAlias(YAML::Mark const& mark, YAML::anchor_t anchor) override {
+			position = mark.pos;
+			auto const iter = anchors.find(anchor);
+			if (iter == anchors.end()) throw std::runtime_error{ "Alias refers to an unknown anchor" };
+			Add(YAML::Clone(iter->second), YAML::NullAnchor);
+		}
+		virtual void OnScalar(YAML::Mark const& mark, std::string const& tag, YAML::anchor_t anchor, std::string const& value) override {
+			position = mark.pos;
+			YAML::Node node{ value };
+			node.SetTag(tag);
+			Add(std::move(node), anchor);
+		}
+
+		virtual void OnSequenceStart(YAML::Mark const& mark, std::string const& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value style) override {
+			position = mark.pos;
+			Push(YAML::NodeType::Sequence, tag, anchor, style);
+		}
+		virtual void OnSequenceEnd() override { Pop(); }
+
+		virtual void OnMapStart(YAML::Mark const& mark, std::string const& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value style) override {
+			position = mark.pos;
+			Push(YAML::NodeType::Map, tag, anchor, style);
+		}
+		virtual void OnMapEnd() override { Pop(); }
+
+	private:
+		/** A sequence or map which is still being read */
+		struct Frame {
+			YAML::Node node;
+			YAML::anchor_t anchor = YAML::NullAnchor;
+			/** The key for the next value added to a map */
+			std::optional<YAML::Node> key;
+			/** True for the sequence of resources, whose elements are given to the callback instead of being added */
+			bool is_contents = false;
+		};
+
+		FunctionRef<void(YAML::Node&&, size_t)> callback;
+		/** True if reading stops once the dependencies at the root of the package are read */
+		bool stop_after_dependencies = false;
+		std::vector<Frame> frames;
+		std::unordered_map<YAML::anchor_t, YAML::Node> anchors;
+		/** True if the next node is the value for the contents of the package */
+		bool next_is_contents = false;
+		/** The position in the text of the most recent event */
+		size_t position = 0;
+
+		void Push(YAML::NodeType::value type, std::string const& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value style) {
+			YAML::Node node{ type };
+			node.SetTag(tag);
+			node.SetStyle(style);
+
+			bool const is_contents = std::exchange(next_is_contents, false) && type == YAML::NodeType::Sequence;
+			frames.emplace_back(Frame{ std::move(node), anchor, std::nullopt, is_contents });
+		}
+
+		void Pop() {
+			Frame frame = std::move(frames.back());
+			frames.pop_back();
+			Add(std::move(frame.node), frame.anchor);
+		}
+
+		void Add(YAML::Node node, YAML::anchor_t anchor) {
+			next_is_contents = false;
+			if (anchor != YAML::NullAnchor) anchors.insert_or_assign(anchor, YAML::Clone(node));
+
+			if (frames.empty()) {
+				root = std::move(node);
+				return;
+			}
+
+			Frame& parent = frames.back();
+			if (parent.node.IsSequence()) {
+				if (parent.is_contents) callback(std::move(node), position);
+				else parent.node.push_back(node);
+
+			} else if (!parent.key) {
+				//Only the contents at the root of the package are read separately
+				next_is_contents = frames.size() == 1 && node.IsScalar() && node.Scalar() == contents_name;
+				parent.key = std::move(node);
+
+			} else {
+				bool const is_dependencies = frames.size() == 1 && parent.key->IsScalar() && parent.key->Scalar() == dependencies_name;
+
+				//Keys are inserted without searching for an existing key, so reading a large map does not take quadratic time
+				parent.node.force_insert(*parent.key, node);
+				parent.key.reset();
+
+				//Packages are saved with the dependencies before the contents, so the contents are usually never parsed
+				if (is_dependencies && stop_after_dependencies) {
+					root = parent.node;
+					throw DependenciesRead{};
+				}
+			}
+		}
+	};
+
+	PackageInput_YAML::PackageInput_YAML(std::istream& stream) {
+		std::ostringstream buffer;
+		buffer << stream.rdbuf();
+		text = std::move(buffer).str();
+	}
+
+	PackageInput_YAML::PackageInput_YAML(std::string text)
+		: text(std::move(text))
 	{}
 
-	std::unordered_set<StringID> PackageInput_YAML::GetDependencies() {
+	std::unordered_set<StringID> PackageInput_YAML::GetDependencies() const {
+		//Parsing stops after the dependencies. If the contents come first, they are discarded as they are read.
+		YAML::Node const root = Parse([](YAML::Node&&, size_t) {}, true);
+
 		std::unordered_set<StringID> packages;
 		for (YAML::Node const node : root[dependencies_name]) packages.emplace(node.as<StringID>());
 
@@ -163,18 +407,33 @@ namespace Resources {
 		return packages;
 	}
 
-	std::vector<PackageInput_YAML::InfoTuple> PackageInput_YAML::GetContentsInformation() {
+	std::vector<PackageInput_YAML::InfoTuple> PackageInput_YAML::GetContentsInformation() const {
 		std::vector<InfoTuple> results;
+		ReadContentsInformation([&](InfoTuple&& information, size_t) { results.emplace_back(std::move(information)); });
+		return results;
+	}
 
-		YAML::Node const sequence = root[contents_name];
-		for (YAML::Node const resource_node : sequence) {
-			results.emplace_back(
-				resource_node[name_name].as<StringID>(),
-				resource_node[type_name].as<Reflection::TypeInfoReference>(),
-				resource_node[object_name]
+	void PackageInput_YAML::ReadContentsInformation(FunctionRef<void(InfoTuple&&, size_t)> callback) const {
+		Parse([&](YAML::Node&& resource_node, size_t position) {
+			callback(
+				InfoTuple{
+					resource_node[name_name].as<StringID>(),
+					resource_node[type_name].as<Reflection::TypeInfoReference>(),
+					resource_node[object_name]
+				},
+				position
 			);
-		}
+		}, false);
+	}
 
-		return results;
+	YAML::Node PackageInput_YAML::Parse(FunctionRef<void(YAML::Node&&, size_t)> callback, bool stop_after_dependencies) const {
+		std::ispanstream stream{ std::span<char const>{ text } };
+		YAML::Parser parser{ stream };
+
+		EventReader reader{ callback, stop_after_dependencies };
+		try {
+			parser.HandleNextDocument(reader);
+		} catch (EventReader::DependenciesRead const&) {}
+		return reader.root;
 	}
 }
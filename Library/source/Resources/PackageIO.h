@@ -1,44 +1,115 @@
 #pragma once
 #include "Engine/Archive.h"
+#include "Engine/Compression.h"
 #include "Resources/Package.h"
 #include "Engine/Reflection.h"
 #include "Engine/Core.h"
+#include "Engine/FunctionRef.h"
 #include "Engine/Set.h"
 #include "Engine/StringID.h"
 #include "Engine/Variant.h"
+#include "HAL/MappedFile.h"
 #include "ThirdParty/yaml.h"
 
 namespace Resources {
+	/** The versions of the binary package format */
+	enum class EBinaryPackageVersion : uint32_t {
+		/** Sequential resource records without a header. Resources can only be found by reading every record before them. */
+		Legacy = 0,
+		/** A header followed by a dependency table and a table of contents, which locates each resource within the payload */
+		Indexed = 1,
+		/** The table of contents also records the codec and uncompressed size for each resource */
+		Compressed = 2,
+		/** Floating-point values are stored as their bits. Earlier versions stored them converted to integers, which must be read with Archive::LegacyFloatScope. */
+		ExactFloats = 3,
+
+		Current = ExactFloats,
+	};
+
+	/** Identifies a binary package that starts with a header. Reads as "ANPK" when viewed as bytes. */
+	constexpr uint32_t BinaryPackageMagic = 0x4B504E41;
+
+	/** Options for how a package is written in the binary format */
+	struct BinaryPackageSettings {
+		/** The codec used to compress each resource. Resources are left uncompressed if this is NoCodec, or if the codec cannot reduce their size. */
+		Compression::CodecID codec = Compression::NoCodec;
+		/** Resources smaller than this number of bytes are never compressed, since they gain little and cost time to decompress */
+		size_t min_compressed_size = 4096;
+	};
+
+	/** The data for a single resource within a binary package, which may be compressed */
+	struct BinaryResourceData {
+		/** The largest ratio of uncompressed size to compressed size that will be decompressed. Far larger than the built-in codec can produce, but prevents a corrupted size from causing a huge allocation. */
+		static constexpr size_t MaxCompressionRatio = 1024;
+
+		/** The bytes stored in the package for this resource */
+		std::span<std::byte const> bytes;
+		/** The codec that was used to compress the bytes */
+		Compression::CodecID codec = Compression::NoCodec;
+		/** The size of the data once it is decompressed */
+		size_t uncompressed_size = 0;
+
+		/**
+		 * Get the uncompressed data. Compressed data is decompressed into the buffer, and uncompressed data is returned directly without copying.
+		 * Throws if the uncompressed size is larger than the compressed data could contain.
+		 */
+		std::span<std::byte const> Decompress(std::vector<std::byte>& buffer) const;
+	};
+
 	struct PackageOutput_Binary {
 		std::vector<std::byte> bytes;
 
-		PackageOutput_Binary(Package const& package);
+		PackageOutput_Binary(Package const& package, BinaryPackageSettings const& settings = BinaryPackageSettings{});
+		PackageOutput_Binary(Package::ContentsContainerType const& contents, BinaryPackageSettings const& settings = BinaryPackageSettings{});
 		void Write(std::ostream& stream) const;
 
 	private:
 		static void SerializeDependencies(Archive::Output& archive, Package::ContentsContainerType const& contents);
-		static void SerializeContents(Archive::Output& archive, Package::ContentsContainerType const& contents);
+		static void SerializeContents(Archive::Output& archive, Package::ContentsContainerType const& contents, BinaryPackageSettings const& settings);
 	};
 
 	struct PackageInput_Binary {
-		using InfoTuple = std::tuple<StringID, Reflection::TypeInfoReference, std::span<std::byte const>>;
+		using InfoTuple = std::tuple<StringID, Reflection::TypeInfoReference, BinaryResourceData>;
 
-		std::vector<std::byte> bytes;
-		//@todo This archive imposes a constraint that the getter methods should only ever be called once and in order.
-		//      It would be better to create the archive inside those methods, so they can be called multiple times or in different orders.
-		//      However, that requires better support for writing and skipping subsections in an archive.
-		Archive::Input archive;
+		/** Owns the bytes of the package, which are either copied from a stream, mapped directly from a file, or part of a file that is shared with other packages */
+		std::variant<std::vector<std::byte>, HAL::MappedFile, std::shared_ptr<HAL::MappedFile const>> storage;
+		/** The bytes of the package. Neither kind of storage relocates its contents when moved, so this remains valid if the input is moved. */
+		std::span<std::byte const> bytes;
 
+		/** Read the package by copying all the bytes from the stream */
 		PackageInput_Binary(std::istream& stream);
+		/** Read the package by mapping the file into memory. The data returned for each resource points directly into the mapped file. */
+		PackageInput_Binary(std::filesystem::path const& path);
+		/** Read the package from a range of bytes within a mapped file, which is kept mapped while the input exists */
+		PackageInput_Binary(std::shared_ptr<HAL::MappedFile const> file, std::span<std::byte const> bytes);
+
+		/** Get the version of the format that was used to save this package */
+		inline EBinaryPackageVersion GetVersion() const { return version; }
+		/** True if floating-point values in the resources were stored converted to integers */
+		inline bool HasLegacyFloats() const { return version < EBinaryPackageVersion::ExactFloats; }
+		/** Get the number of bytes in the package */
+		inline size_t GetSize() const { return bytes.size(); }
 
-		std::unordered_set<StringID> GetDependencies();
-		std::vector<InfoTuple> GetContentsInformation();
+		std::unordered_set<StringID> GetDependencies() const;
+		std::vector<InfoTuple> GetContentsInformation() const;
+
+	private:
+		EBinaryPackageVersion version = EBinaryPackageVersion::Legacy;
+		std::unordered_set<StringID> dependencies;
+		/** The table of contents for this package, in the same order as the resource data */
+		std::vector<InfoTuple> contents;
+
+		static std::vector<std::byte> ExtractAllBytes(std::istream& stream);
+
+		/** Read the dependencies and the table of contents. Only the data for each resource is left unread. */
+		void ReadIndex();
 	};
 
 	struct PackageOutput_YAML {
 		YAML::Node root;
 
 		PackageOutput_YAML(Package const& package);
+		PackageOutput_YAML(Package::ContentsContainerType const& contents);
 		void Write(std::ostream& stream) const;
 
 	private:
@@ -46,15 +117,39 @@ namespace Resources {
 		static YAML::Node SerializeContents(Package::ContentsContainerType const& contents);
 	};
 
+	/**
+	 * Reads a package from YAML text. The text is read with parser events instead of being loaded into a node tree for the whole package,
+	 * and the node for each resource is built separately from the nodes for other resources.
+	 */
 	struct PackageInput_YAML {
 		using InfoTuple = std::tuple<StringID, Reflection::TypeInfoReference, YAML::Node>;
 
-		YAML::Node root;
-
+		/** Read the package by copying all the text from the stream. The text is not parsed until the dependencies or contents are requested, and reading the dependencies only parses the text up to the end of the dependencies. */
 		PackageInput_YAML(std::istream& stream);
+		/** Read the package from text that was already loaded */
+		PackageInput_YAML(std::string text);
+
+		/** Get the number of bytes in the text of the package */
+		inline size_t GetSize() const { return text.size(); }
+
+		std::unordered_set<StringID> GetDependencies() const;
+		std::vector<InfoTuple> GetContentsInformation() const;
+		/**
+		 * Read the contents one resource at a time, giving each resource to the callback as soon as it is read along with the number of bytes of text read so far.
+		 * The node for each resource does not share memory with any other node, so different resources can be deserialized on different threads.
+		 */
+		void ReadContentsInformation(FunctionRef<void(InfoTuple&&, size_t)> callback) const;
+
+	private:
+		struct EventReader;
+
+		std::string text;
 
-		std::unordered_set<StringID> GetDependencies();
-		std::vector<InfoTuple> GetContentsInformation();
+		/**
+		 * Parse the text, giving each resource node to the callback. Returns the root node of the package, with an empty sequence in place of the contents.
+		 * If stopping after the dependencies, the root node only contains the values that were read up to and including the dependencies.
+		 */
+		YAML::Node Parse(FunctionRef<void(YAML::Node&&, size_t)> callback, bool stop_after_dependencies) const;
 	};
 
 	using PackageOutput = std::variant<PackageOutput_Binary, PackageOutput_YAML>;
@@ -23,7 +23,7 @@ namespace Resources {
 		return Identifier{ pinned ? pinned->GetName() : StringID::None, description->name };
 	}
 
-	IResourceProvider const* IResourceProvider::scoped_provider = nullptr;
+	thread_local IResourceProvider const* IResourceProvider::scoped_provider = nullptr;
 }
 
 namespace Archive {
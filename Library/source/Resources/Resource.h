@@ -11,6 +11,7 @@
 namespace Resources {
 	struct Cache;
 	struct Package;
+	template<typename ResourceType> struct TCache;
 
 	/** Base class for an object that can be shared between many entities and scenes, and is tracked with reference counting */
 	struct Resource : public std::enable_shared_from_this<Resource> {
@@ -24,10 +25,17 @@ namespace Resources {
 		std::shared_ptr<Package const> GetPackage() const;
 		Identifier GetIdentifier() const;
 
+		/** Get an estimate of the memory used by this resource, in bytes. Resources which own additional memory should include it. */
+		virtual size_t GetMemorySize() const { return GetTypeInfo().size; }
+
+		/** True if the cache that contains this resource is destroying it. A resource that is being destroyed must not be used. */
+		inline bool IsEvicting() const { return evicting.load(std::memory_order_relaxed); }
+
 	private:
 		friend struct Database;
 		friend struct Package;
 		friend struct ResourceUtility;
+		template<typename ResourceType> friend struct TCache;
 
 		/** The fundamental information that describes a resource */
 		struct ResourceDescription {
@@ -43,11 +51,13 @@ namespace Resources {
 
 		/** The fundamental information that describes this resource, which must be thread-safe. */
 		ThreadSafe<ResourceDescription> ts_description;
+		/** Set by the cache before it checks whether this resource can be destroyed, so readers that did not lock the cache can avoid using it */
+		std::atomic<bool> evicting = false;
 	};
 
 	/** Generic interface for classes that can provide resources based on an identifier */
 	struct IResourceProvider {
-		/** Creates a scope within which serialization can retrieve resource handles using a serialized identifier. These scopes must not be nested. */
+		/** Creates a scope within which serialization can retrieve resource handles using a serialized identifier. These scopes must not be nested within the same thread. */
 		struct ProviderScope {
 			ProviderScope(IResourceProvider const& provider) {
 				assert(scoped_provider == nullptr);
@@ -66,7 +76,7 @@ namespace Resources {
 		virtual std::shared_ptr<Resource> FindResource(Identifier id) const noexcept = 0;
 
 	private:
-		static IResourceProvider const* scoped_provider;
+		static thread_local IResourceProvider const* scoped_provider;
 	};
 
 	namespace Concepts {
@@ -80,6 +90,19 @@ namespace Resources {
 	/** A handle that may point to a Resource object */
 	template<typename T>
 	using Handle = std::shared_ptr<T>;
+
+	/**
+	 * Lock a weak handle to a resource without holding the lock of the cache that contains the resource. Returns an empty handle if the cache is evicting the resource,
+	 * since the cache may notify external systems that the resource was destroyed while it is still being used.
+	 */
+	template<std::derived_from<Resource> ResourceType>
+	std::shared_ptr<ResourceType> LockHandle(std::weak_ptr<ResourceType> const& handle) {
+		std::shared_ptr<ResourceType> resource = handle.lock();
+		//Pairs with the fence in the cache, so either the cache sees that the resource is used, or this sees that the resource is being evicted
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (resource && resource->IsEvicting()) return nullptr;
+		return resource;
+	}
 }
 
 REFLECT(Resources::Resource, Struct);
@@ -0,0 +1,85 @@
+#include "Resources/ResourceIndex.h"
+#include "Resources/Resource.h"
+
+namespace Resources {
+	ResourceIndex::ResourceIndex()
+		: table(std::make_shared<Table>(MinimumCapacity))
+	{}
+
+	std::shared_ptr<Resource> ResourceIndex::Find(Identifier id) const noexcept {
+		std::shared_ptr<Table const> const current = table.load();
+		if (Slot const* slot = FindOccupiedSlot(*current, id)) return LockHandle(slot->resource);
+		else return nullptr;
+	}
+
+	void ResourceIndex::Insert(Identifier id, std::shared_ptr<Resource> const& resource) {
+		std::scoped_lock const lock{ write_mutex };
+		std::shared_ptr<Table> current = table.load();
+
+		if (Slot* slot = FindOccupiedSlot(*current, id)) {
+			slot->state.store(ESlotState::Removed, std::memory_order_release);
+			--current->num_occupied;
+		}
+
+		//Probe sequences become long as the table fills up, so the table is replaced once half of the slots are used.
+		//Removed slots can't be reused while readers may be probing past them, so they are only reclaimed by replacing the table.
+		if ((current->num_used + 1) * 2 > current->capacity) {
+			size_t const capacity = std::max(std::bit_ceil((current->num_occupied + 1) * 4), MinimumCapacity);
+			std::shared_ptr<Table> next = std::make_shared<Table>(capacity);
+
+			for (size_t index = 0; index < current->capacity; ++index) {
+				Slot const& slot = current->slots[index];
+				if (slot.state.load(std::memory_order_relaxed) == ESlotState::Occupied) WriteSlot(*next, slot.id, slot.resource.lock());
+			}
+
+			table.store(next);
+			current = std::move(next);
+		}
+
+		WriteSlot(*current, id, resource);
+	}
+
+	void ResourceIndex::Remove(Identifier id) {
+		std::scoped_lock const lock{ write_mutex };
+		std::shared_ptr<Table> const current = table.load();
+
+		if (Slot* slot = FindOccupiedSlot(*current, id)) {
+			slot->state.store(ESlotState::Removed, std::memory_order_release);
+			--current->num_occupied;
+		}
+	}
+
+	ResourceIndex::Slot* ResourceIndex::FindOccupiedSlot(Table const& table, Identifier id) {
+		size_t const mask = table.capacity - 1;
+
+		for (size_t position = GetStartPosition(table, id);; position = (position + 1) & mask) {
+			Slot& slot = table.slots[position];
+
+			switch (slot.state.load(std::memory_order_acquire)) {
+			case ESlotState::Empty:
+				return nullptr;
+			case ESlotState::Occupied:
+				if (slot.id == id) return &slot;
+				break;
+			case ESlotState::Removed:
+				break;
+			}
+		}
+	}
+
+	void ResourceIndex::WriteSlot(Table& table, Identifier id, std::shared_ptr<Resource> const& resource) {
+		size_t const mask = table.capacity - 1;
+
+		size_t position = GetStartPosition(table, id);
+		while (table.slots[position].state.load(std::memory_order_relaxed) != ESlotState::Empty) position = (position + 1) & mask;
+
+		//The entry is written before the slot becomes occupied, so readers never see a partially written entry
+		Slot& slot = table.slots[position];
+		slot.id = id;
+		slot.resource = resource;
+		slot.state.store(ESlotState::Occupied, std::memory_order_release);
+
+		++table.num_used;
+		++table.num_occupied;
+	}
+}
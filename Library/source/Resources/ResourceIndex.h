@@ -0,0 +1,68 @@
+#pragma once
+#include "Engine/Core.h"
+#include "Engine/SmartPointers.h"
+#include "Engine/Threads.h"
+#include "Resources/ResourceTypes.h"
+
+namespace Resources {
+	struct Resource;
+
+	/**
+	 * A flat index of resources by identifier, which can be searched without locking.
+	 * Resources are stored in an open-addressing table. Entries are written once before they become visible, and removed entries are only marked as removed,
+	 * so readers never see an entry while it is being modified. When the table runs out of space, a new table is published and readers of the previous table
+	 * can continue using it until they are finished. Modifications are serialized with each other.
+	 */
+	struct ResourceIndex {
+		ResourceIndex();
+
+		/** Find the resource with the identifier. Returns nullptr if the resource is not in the index, no longer exists, or is being evicted from its cache. */
+		std::shared_ptr<Resource> Find(Identifier id) const noexcept;
+
+		/** Add a resource to the index, replacing any existing resource with the same identifier */
+		void Insert(Identifier id, std::shared_ptr<Resource> const& resource);
+		/** Remove the resource with the identifier from the index. Does nothing if the resource is not in the index. */
+		void Remove(Identifier id);
+
+	private:
+		enum class ESlotState : uint8_t {
+			Empty,
+			Occupied,
+			Removed,
+		};
+
+		struct Slot {
+			/** The state of the slot. The other members are only written while the slot is empty, and may be read once the slot is occupied. */
+			std::atomic<ESlotState> state = ESlotState::Empty;
+			Identifier id;
+			std::weak_ptr<Resource> resource;
+		};
+
+		struct Table {
+			/** The number of slots, which is always a power of two */
+			size_t capacity = 0;
+			std::unique_ptr<Slot[]> slots;
+
+			/** The number of slots which are not empty, including removed slots. Only used when modifying the table. */
+			size_t num_used = 0;
+			/** The number of slots which are occupied. Only used when modifying the table. */
+			size_t num_occupied = 0;
+
+			Table(size_t capacity) : capacity(capacity), slots(std::make_unique<Slot[]>(capacity)) {}
+		};
+
+		/** The minimum number of slots in a table */
+		static constexpr size_t MinimumCapacity = 64;
+
+		/** The current table. Replaced when a larger table is needed, or when too many slots have been removed. */
+		std::atomic<std::shared_ptr<Table>> table;
+		/** Serializes modifications to the table */
+		std::mutex write_mutex;
+
+		static inline size_t GetStartPosition(Table const& table, Identifier id) { return std::hash<Identifier>{}(id) & (table.capacity - 1); }
+		/** Find the slot that is occupied by the identifier. Returns nullptr if there is no slot with the identifier. */
+		static Slot* FindOccupiedSlot(Table const& table, Identifier id);
+		/** Write a new entry into an empty slot, which must exist */
+		static void WriteSlot(Table& table, Identifier id, std::shared_ptr<Resource> const& resource);
+	};
+}
@@ -40,6 +40,9 @@ namespace Resources {
 				currentContents->erase(description->name);
 				description->package = destination;
 
+				if (auto const database = current->owner.lock()) database->index.Remove(Identifier{ current->name, description->name });
+				if (auto const database = destination->owner.lock()) database->index.Insert(Identifier{ destination->name, description->name }, resource);
+
 				current->flags += EPackageFlags::Dirty;
 				destination->flags += EPackageFlags::Dirty;
 
@@ -52,6 +55,8 @@ namespace Resources {
 				destinationContents->emplace(std::make_pair(description->name, resource));
 				description->package = destination;
 
+				if (auto const database = destination->owner.lock()) database->index.Insert(Identifier{ destination->name, description->name }, resource);
+
 				destination->flags += EPackageFlags::Dirty;
 			}
 		}
@@ -73,6 +78,16 @@ namespace Resources {
 		//Perform the rename
 		packages->emplace(name, package);
 		packages->erase(package->name);
+
+		//Every resource in the package has a new identifier
+		{
+			auto const contents = package->ts_contents.LockInclusive();
+			for (auto const& [resource_name, resource] : *contents) {
+				database->index.Remove(Identifier{ package->name, resource_name });
+				database->index.Insert(Identifier{ name, resource_name }, resource);
+			}
+		}
+
 		package->name = name;
 	}
 
@@ -93,8 +108,14 @@ namespace Resources {
 			}
 
 			//Update the package contents with the new name
-			contents->emplace(std::make_pair(name, resource.get()));
+			contents->emplace(std::make_pair(name, resource));
 			contents->erase(description->name);
+
+			if (auto const database = package->owner.lock()) {
+				database->index.Remove(Identifier{ package->name, description->name });
+				database->index.Insert(Identifier{ package->name, name }, resource);
+			}
+
 			description->name = name;
 
 		} else {
@@ -1,6 +1,8 @@
 #include "Resources/Streaming.h"
 
 namespace Resources {
+	DEFINE_PROFILE_CATEGORY(Streaming);
+
 	bool PackageRequestHandle::HasFailed() const {
 		auto const result = request->ts_result.LockInclusive();
 		return result->has_value() && !result->value().has_value();
@@ -11,6 +13,44 @@ namespace Resources {
 		return result->has_value() ? result->value().value_or(nullptr) : nullptr;
 	}
 
+	float PackageRequestHandle::GetProgress() const {
+		//Dependencies that are shared by several packages in the tree are only counted once
+		uint64_t done = 0;
+		uint64_t total = 0;
+		std::unordered_set<PackageRequest const*> visited{ request.get() };
+		std::vector<PackageRequest const*> stack{ request.get() };
+
+		while (stack.size() > 0) {
+			PackageRequest const* current = stack.back();
+			stack.pop_back();
+
+			auto const [current_done, current_total] = current->GetWork();
+			done += current_done;
+			total += current_total;
+
+			if (!current->has_dependencies.load(std::memory_order_acquire)) continue;
+			for (std::shared_ptr<PackageRequest> const& dependency : current->dependencies) {
+				if (visited.insert(dependency.get()).second) stack.emplace_back(dependency.get());
+			}
+		}
+
+		//Dependencies are discovered as sources are read, which increases the total work. The reported progress should not go backwards when this happens.
+		float const progress = static_cast<float>(static_cast<double>(done) / static_cast<double>(total));
+		float reported = request->progress;
+		while (progress > reported && !request->progress.compare_exchange_weak(reported, progress));
+		return std::max(progress, reported);
+	}
+
+	void PackageRequestHandle::Cancel() {
+		{
+			auto const result = request->ts_result.LockExclusive();
+			if (result->has_value()) return;
+			result->emplace(std::unexpected<std::string>("Request was canceled"));
+		}
+		request->cancellation.request_stop();
+		request->ts_result.Notify();
+	}
+
 	std::shared_ptr<Package> PackageRequestHandle::Wait() {
 		auto const result = request->ts_result.WaitInclusive(&IsResultReady);
 		return result->value().value_or(nullptr);
@@ -26,16 +66,96 @@ namespace Resources {
 		else return nullptr;
 	}
 
-	StreamingDatabase::StreamingDatabase() : async_request_thread(*this), thread(CreateThread(async_request_thread)) {}
+	bool PackageSaveHandle::IsFinished() const {
+		return request->ts_result.LockInclusive()->has_value();
+	}
+
+	std::optional<std::string> PackageSaveHandle::GetError() const {
+		auto const result = request->ts_result.LockInclusive();
+		if (result->has_value() && !result->value().has_value()) return result->value().error();
+		return std::nullopt;
+	}
+
+	bool PackageSaveHandle::Wait() {
+		auto const result = request->ts_result.WaitInclusive(&IsResultReady);
+		return result->value().has_value();
+	}
+
+	bool PackageSaveHandle::Wait(std::chrono::high_resolution_clock::time_point time) {
+		if (auto const possible = request->ts_result.WaitInclusive(time, &IsResultReady)) return (*possible)->value().has_value();
+		else return false;
+	}
+
+	bool PackageSaveHandle::Wait(std::chrono::milliseconds duration) {
+		if (auto const possible = request->ts_result.WaitInclusive(duration, &IsResultReady)) return (*possible)->value().has_value();
+		else return false;
+	}
+
+	StreamingDatabase::StreamingDatabase(size_t num_workers)
+		: async_requests(*this), async_saves(*this)
+	{
+		read_thread = std::jthread{ std::bind_front(&AsyncRequestQueue::ReadSources, &async_requests) };
+
+		decode_threads.reserve(std::max<size_t>(num_workers, 1));
+		for (size_t index = 0; index < std::max<size_t>(num_workers, 1); ++index) {
+			decode_threads.emplace_back(std::bind_front(&AsyncRequestQueue::DecodeSources, &async_requests));
+		}
+
+		save_thread = CreateThread(async_saves);
+	}
+
+	size_t StreamingDatabase::GetDefaultWorkerCount() {
+		//Leave some hardware threads for the main thread and rendering. hardware_concurrency may return 0 if it cannot be determined.
+		return std::max<size_t>(std::thread::hardware_concurrency() / 2, 1);
+	}
+
+	void StreamingDatabase::StopStreaming() {
+		//Request all threads to stop before joining any of them, so they can all wind down at the same time
+		read_thread.request_stop();
+		for (std::jthread& thread : decode_threads) thread.request_stop();
+		save_thread.request_stop();
+
+		if (read_thread.joinable()) read_thread.join();
+		for (std::jthread& thread : decode_threads) {
+			if (thread.joinable()) thread.join();
+		}
+		if (save_thread.joinable()) save_thread.join();
+	}
 
 	bool StreamingDatabase::SavePackage(StringID name) {
+		//Saves are still performed on the saving thread, so they are ordered with any asynchronous saves of the same package
+		return SavePackageAsync(name).Wait();
+	}
+
+	PackageSaveHandle StreamingDatabase::SavePackageAsync(StringID name) {
 		std::shared_ptr<Package> const package = FindPackage(name);
 		if (!package) throw FormatType<std::runtime_error>("Cannot find package {} when attempting to save", name);
-		return SavePackage(*package);
+
+		//The snapshot contains all changes up to this point, so the package is no longer dirty. It will become dirty again if the save fails.
+		Package::ContentsContainerType contents = *package->GetContentsView();
+		package->flags -= EPackageFlags::Dirty;
+
+		return async_saves.CreateRequest(name, std::move(contents));
+	}
+
+	void StreamingDatabase::CancelSave(StringID name) {
+		async_saves.CancelRequest(name);
 	}
 
 	PackageRequestHandle StreamingDatabase::LoadPackage(StringID name, RequestPriority priority) {
-		return async_request_thread.CreateRequest(name, priority);
+		return async_requests.CreateRequest(name, priority);
+	}
+
+	StreamingStatistics StreamingDatabase::GetStreamingStats() const {
+		return async_requests.GetStatistics();
+	}
+
+	void StreamingDatabase::ResetStreamingStats() {
+		async_requests.ResetStatistics();
+	}
+
+	size_t StreamingDatabase::ReloadPackageContents(std::shared_ptr<Package> const& package, PackageInput& source) {
+		return std::visit([this, &package](auto& source) { return ReloadContents(package, source); }, source);
 	}
 
 	std::shared_ptr<Resource> StreamingDatabase::CreateResource(StringID id, Reflection::StructTypeInfo const& type, absl::FunctionRef<void(Resource&)> initializer) {
@@ -47,211 +167,806 @@ namespace Resources {
 		return cache->Create(id, initializer);
 	}
 
-	std::unordered_map<StringID, std::shared_ptr<Resource>> StreamingDatabase::CreateContents(PackageInput_Binary& source) {
+	std::vector<std::shared_ptr<Resource>> StreamingDatabase::CreateResourceBatch(Reflection::StructTypeInfo const& type, std::span<StringID const> ids, absl::FunctionRef<void(Resource&, size_t)> initializer) {
+		if (!type.IsChildOf<Resource>()) {
+			throw FormatType<std::runtime_error>("Type {} does not derive from Resource, cannot use this to create resources", type.name);
+		}
+
+		std::shared_ptr<Cache> const cache = FindOrCreateCache(type);
+		return cache->CreateBatch(ids, initializer);
+	}
+
+	std::unordered_map<StringID, std::shared_ptr<Resource>> StreamingDatabase::CreateContents(PackageInput_Binary& source, std::stop_token token, std::atomic<uint64_t>& work_done) {
 		using namespace Reflection;
 
+		//Resources are created in one batch for each type, so each cache is only locked once and observers are notified once for each type.
+		//Each resource is deserialized from a separate section of the source, so the resources within a batch are created in parallel.
+		auto const information = source.GetContentsInformation();
+
+		std::unordered_map<StructTypeInfo const*, std::vector<size_t>> batches;
+		for (size_t index = 0; index < information.size(); ++index) {
+			if (auto const* type = std::get<1>(information[index]).Resolve<StructTypeInfo>()) batches[type].emplace_back(index);
+		}
+
 		std::unordered_map<StringID, std::shared_ptr<Resource>> results;
+		results.reserve(information.size());
 
-		for (auto const [id, type_reference, buffer] : source.GetContentsInformation()) {
-			if (auto const* type = type_reference.Resolve<StructTypeInfo>()) {
-				auto const initialize = [&](Resource& resource) {
-					Archive::Input archive{ buffer };
-					type->Deserialize(archive, &resource);
-				};
+		std::vector<StringID> ids;
+		for (auto const& [type, indices] : batches) {
+			if (token.stop_requested()) throw std::runtime_error{ "Request was canceled" };
 
-				if (auto const resource = CreateResource(id, *type, initialize)) {
-					results.emplace(std::make_pair(id, resource));
-				}
+			ids.clear();
+			for (size_t const index : indices) ids.emplace_back(std::get<0>(information[index]));
+
+			auto const initialize = [&](Resource& resource, size_t batch_index) {
+				//Skip the remaining resources if the request is canceled while they are being created
+				if (token.stop_requested()) throw std::runtime_error{ "Request was canceled" };
+
+				//Compressed resources are decompressed here, so that decompression is spread across the workers along with deserialization
+				BinaryResourceData const& data = std::get<2>(information[indices[batch_index]]);
+				std::vector<std::byte> decompressed;
+				std::span<std::byte const> const buffer = data.Decompress(decompressed);
+
+				//Resource handles within the contents can only be resolved if a provider is available while they are deserialized
+				auto const scope = CreateResourceProviderScope();
+				Archive::LegacyFloatScope const floats{ source.HasLegacyFloats() };
+				Archive::Input archive{ buffer };
+				type->Deserialize(archive, &resource);
+
+				work_done += data.bytes.size();
+			};
+
+			std::vector<std::shared_ptr<Resource>> const resources = CreateResourceBatch(*type, ids, initialize);
+			for (size_t batch_index = 0; batch_index < resources.size(); ++batch_index) {
+				results.emplace(std::make_pair(ids[batch_index], resources[batch_index]));
 			}
 		}
 
 		return results;
 	}
 
-	std::unordered_map<StringID, std::shared_ptr<Resource>> StreamingDatabase::CreateContents(PackageInput_YAML& source) {
+	std::unordered_map<StringID, std::shared_ptr<Resource>> StreamingDatabase::CreateContents(PackageInput_YAML& source, std::stop_token token, std::atomic<uint64_t>& work_done) {
 		using namespace Reflection;
-		
+
+		//Resources are read from the source one at a time, and deserialized in batches once enough have been read. Only the nodes for one batch exist at the same time.
+		//The node for each resource is separate from the other nodes, so the resources within a batch are created in parallel.
 		std::unordered_map<StringID, std::shared_ptr<Resource>> results;
+		std::vector<PackageInput_YAML::InfoTuple> pending;
+		pending.reserve(MaxPendingTextResources);
 
-		for (auto const [id, type_reference, object] : source.GetContentsInformation()) {
-			if (auto const* type = type_reference.Resolve<Reflection::StructTypeInfo>()) {
-				auto const initialize = [&](Resource& resource) { type->Deserialize(object, &resource); };
+		std::unordered_map<StructTypeInfo const*, std::vector<size_t>> batches;
+		std::vector<StringID> ids;
+
+		auto const create_pending = [&]() {
+			batches.clear();
+			for (size_t index = 0; index < pending.size(); ++index) {
+				if (auto const* type = std::get<1>(pending[index]).Resolve<StructTypeInfo>()) batches[type].emplace_back(index);
+			}
+
+			for (auto const& [type, indices] : batches) {
+				if (token.stop_requested()) throw std::runtime_error{ "Request was canceled" };
+
+				ids.clear();
+				for (size_t const index : indices) ids.emplace_back(std::get<0>(pending[index]));
 
-				if (auto const resource = CreateResource(id, *type, initialize)) {
-					results.emplace(std::make_pair(id, resource));
+				auto const initialize = [&](Resource& resource, size_t batch_index) {
+					//Skip the remaining resources if the request is canceled while they are being created
+					if (token.stop_requested()) throw std::runtime_error{ "Request was canceled" };
+
+					//Resource handles within the contents can only be resolved if a provider is available while they are deserialized
+					auto const scope = CreateResourceProviderScope();
+					type->Deserialize(std::get<2>(pending[indices[batch_index]]), &resource);
+				};
+
+				std::vector<std::shared_ptr<Resource>> const resources = CreateResourceBatch(*type, ids, initialize);
+				for (size_t batch_index = 0; batch_index < resources.size(); ++batch_index) {
+					results.emplace(std::make_pair(ids[batch_index], resources[batch_index]));
 				}
 			}
-		}
 
+			pending.clear();
+		};
+
+		//Progress is measured by how much of the text has been read
+		size_t reported_position = 0;
+
+		source.ReadContentsInformation([&](PackageInput_YAML::InfoTuple&& information, size_t position) {
+			if (token.stop_requested()) throw std::runtime_error{ "Request was canceled" };
+
+			pending.emplace_back(std::move(information));
+			if (pending.size() >= MaxPendingTextResources) create_pending();
+
+			work_done += position - std::min(reported_position, position);
+			reported_position = std::max(reported_position, position);
+		});
+		create_pending();
+
+		work_done += source.GetSize() - std::min(reported_position, source.GetSize());
 		return results;
 	}
 
-	StreamingDatabase::AsyncRequestThread::AsyncRequestThread(StreamingDatabase& database)
-		: database(database)
-	{}
+	size_t StreamingDatabase::ReloadContents(std::shared_ptr<Package> const& package, PackageInput_Binary& source) {
+		using namespace Reflection;
 
-	void StreamingDatabase::AsyncRequestThread::operator()(std::stop_token token) {
-		struct DependencySearcher {
-			/** Perform a depth-first search and return the first unloaded nested dependency of the provided package which can be loaded. Returns the provided package if all dependencies are loaded. */
-			std::shared_ptr<PackageRequest> Search(std::shared_ptr<PackageRequest> const& current) {
-				visited.clear();
-				return SearchInternal(current);
+		std::unordered_set<StringID> reloaded;
+		size_t num_changed = 0;
+
+		std::vector<std::byte> decompressed;
+		std::vector<std::byte> current;
+
+		for (auto const& [id, type_reference, data] : source.GetContentsInformation()) {
+			auto const* type = type_reference.Resolve<StructTypeInfo>();
+			if (!type) continue;
+
+			reloaded.emplace(id);
+			std::span<std::byte const> const buffer = data.Decompress(decompressed);
+
+			auto const initialize = [&](Resource& resource) {
+				//Resource handles within the contents can only be resolved if a provider is available while they are deserialized
+				auto const scope = CreateResourceProviderScope();
+				Archive::LegacyFloatScope const floats{ source.HasLegacyFloats() };
+				Archive::Input archive{ buffer };
+				type->Deserialize(archive, &resource);
+			};
+
+			std::shared_ptr<Resource> const existing = package->Find(id);
+			try {
+				if (existing && &existing->GetTypeInfo() == type) {
+					//Serializing the existing resource is much cheaper than deserializing it again, and avoids rebuilding anything that observers derive from it
+					current.clear();
+					Archive::Output archive{ current };
+					type->Serialize(archive, existing.get());
+					if (ranges::equal(current, buffer)) continue;
+
+					//Variables that were reset to their defaults or removed from the package are omitted from the data, so they must be reset before reading it
+					FindOrCreateCache(*type)->Update(*existing, [&](Resource& resource) {
+						StructSerializationHelpers::ResetVariables(*type, &resource);
+						initialize(resource);
+					});
+
+				} else {
+					ReplaceReloadedResource(package, existing, id, *type, initialize);
+				}
+				++num_changed;
+
+			} catch (std::exception const& e) {
+				LOG(Resources, Warning, "Unable to reload resource {} in package {}: {}", id, package->GetName(), e.what());
 			}
-			
-		private:
-			std::unordered_set<PackageRequest const*> visited;
+		}
+
+		return num_changed + RemoveReloadedResources(package, reloaded);
+	}
 
-			std::shared_ptr<PackageRequest> SearchInternal(std::shared_ptr<PackageRequest> const& current) {
-				for (std::shared_ptr<PackageRequest> const& shared_dependency : current->dependencies) {
-					PackageRequest const& dependency = *shared_dependency;
+	size_t StreamingDatabase::ReloadContents(std::shared_ptr<Package> const& package, PackageInput_YAML& source) {
+		using namespace Reflection;
+
+		//Nodes are compared using their emitted text, so differences in how the nodes are structured in memory are ignored
+		auto const emit = [](YAML::Node const& node) {
+			YAML::Emitter emitter;
+			emitter << node;
+			return std::string{ emitter.c_str() };
+		};
 
-					auto const result = visited.insert(&dependency);
-					bool const was_visited = !result.second;
+		std::unordered_set<StringID> reloaded;
+		size_t num_changed = 0;
 
-					if (!was_visited && dependency.IsPending()) {
-						return SearchInternal(shared_dependency);
-					}
+		for (auto const [id, type_reference, object] : source.GetContentsInformation()) {
+			auto const* type = type_reference.Resolve<StructTypeInfo>();
+			if (!type) continue;
+
+			reloaded.emplace(id);
+
+			auto const initialize = [&](Resource& resource) {
+				//Resource handles within the contents can only be resolved if a provider is available while they are deserialized
+				auto const scope = CreateResourceProviderScope();
+				type->Deserialize(object, &resource);
+			};
+
+			std::shared_ptr<Resource> const existing = package->Find(id);
+			try {
+				if (existing && &existing->GetTypeInfo() == type) {
+					if (emit(type->Serialize(existing.get())) == emit(object)) continue;
+
+					//Variables that were reset to their defaults or removed from the package are omitted from the data, so they must be reset before reading it
+					FindOrCreateCache(*type)->Update(*existing, [&](Resource& resource) {
+						StructSerializationHelpers::ResetVariables(*type, &resource);
+						initialize(resource);
+					});
+
+				} else {
+					ReplaceReloadedResource(package, existing, id, *type, initialize);
 				}
+				++num_changed;
 
-				//If none of the nested dependencies were unloaded, return this package itself.
-				return current;
+			} catch (std::exception const& e) {
+				LOG(Resources, Warning, "Unable to reload resource {} in package {}: {}", id, package->GetName(), e.what());
 			}
+		}
+
+		return num_changed + RemoveReloadedResources(package, reloaded);
+	}
+
+	void StreamingDatabase::ReplaceReloadedResource(std::shared_ptr<Package> const& package, std::shared_ptr<Resource> const& existing, StringID id, Reflection::StructTypeInfo const& type, absl::FunctionRef<void(Resource&)> initializer) {
+		//A resource cannot change its type, so a resource with the new type must be created in its place
+		if (existing) ResourceUtility::MoveResource(existing, GetTemporary());
+
+		auto const initialize = [&](Resource& resource) {
+			initializer(resource);
+			ResourceUtility::MoveResource(resource.shared_from_this(), package);
 		};
+		CreateResource(id, type, initialize);
+	}
+
+	size_t StreamingDatabase::RemoveReloadedResources(std::shared_ptr<Package> const& package, std::unordered_set<StringID> const& reloaded) {
+		std::vector<std::shared_ptr<Resource>> removed;
+		{
+			auto const contents = package->GetContentsView();
+			for (auto const& [id, resource] : *contents) {
+				if (!reloaded.contains(id)) removed.emplace_back(resource);
+			}
+		}
 
-		DependencySearcher searcher;
+		//Removed resources may still be referenced elsewhere, so they are moved to the temporary package instead of being destroyed
+		size_t num_removed = 0;
+		for (std::shared_ptr<Resource> const& resource : removed) {
+			try {
+				ResourceUtility::MoveResource(resource, GetTemporary());
+				++num_removed;
+			} catch (std::exception const& e) {
+				LOG(Resources, Warning, "Unable to remove resource from reloaded package {}: {}", package->GetName(), e.what());
+			}
+		}
+		return num_removed;
+	}
 
-		while (!token.stop_requested()) {
-			//@todo Clean the requests, removing requests that no longer have any external references.
-			//      This must be an interative process, because when we remove a request that may mean other requests now have no external references.
+	StreamingDatabase::AsyncRequestQueue::AsyncRequestQueue(StreamingDatabase& database)
+		: database(database)
+	{}
 
-			if (std::shared_ptr<PackageRequest> const highest = GetHighestPriorityRequest(token)) {
-				//@todo Check if the package is already canceled, and return early if it is.
-				//      We should be periodically re-checking whether the package has been canceled, so we can stop and process another package instead.
+	void StreamingDatabase::AsyncRequestQueue::ReadSources(std::stop_token token) {
+		std::stop_callback const wake_on_stop{ token, [this]() { WakeAll(); } };
 
-				std::shared_ptr<PackageRequest> const current = searcher.Search(highest);
+		while (!token.stop_requested()) {
+			if (std::shared_ptr<PackageRequest> const current = ClaimRequest(token, EPackageRequestStage::Reading)) {
+				SampleQueueDepth();
 
+				//Reading the source cannot be interrupted, so cancellation is checked once it has been read
 				try {
-					if (!current->source.has_value()) {
+					current->telemetry.read_begin = Profiling::Now();
+					{
+						PROFILE_DURATION("ReadPackageSource", Streaming);
 						current->source.emplace(database.LoadPackageSource(current->name));
+					}
+					current->telemetry.read_end = Profiling::Now();
+					current->telemetry.num_bytes = std::visit([](auto const& source) { return source.GetSize(); }, *current->source);
 
-						const auto dependencies = std::visit([](auto& source) { return source.GetDependencies(); }, *current->source);
-						current->dependencies = CreateDependencyRequests(dependencies);
-						continue;
+					//The actual size replaces the estimate. The source is now read, but none of its resources have been created yet.
+					uint64_t const size = std::max<uint64_t>(current->telemetry.num_bytes, 1);
+					current->work_total = size * 2;
+					current->work_done = size;
 
-					} else {
-						const auto contents = std::visit([this](auto& source) { return database.CreateContents(source); }, *current->source);
+					total_bytes_read += current->telemetry.num_bytes;
+					PROFILE_COUNTER("StreamingBytesRead", Streaming, total_bytes_read.load());
 
-						std::shared_ptr<Package> const package = database.CreatePackageWithContents(current->name, contents);
+					const auto dependencies = std::visit([](auto& source) { return source.GetDependencies(); }, *current->source);
+					AssignDependencyRequests(*current, dependencies);
 
-						auto result = current->ts_result.LockExclusive();
-						result->emplace(package);
-					}
 				} catch (std::exception const& e) {
-					auto result = current->ts_result.LockExclusive();
-					result->emplace(std::unexpected<std::string>(e.what()));
+					FinishRequest(current, std::unexpected<std::string>(e.what()));
 				}
+			}
+		}
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::DecodeSources(std::stop_token token) {
+		std::stop_callback const wake_on_stop{ token, [this]() { WakeAll(); } };
+
+		while (!token.stop_requested()) {
+			if (std::shared_ptr<PackageRequest> const current = ClaimRequest(token, EPackageRequestStage::Decoding)) {
+				SampleQueueDepth();
+
+				try {
+					std::stop_token const token = current->cancellation.get_token();
+
+					current->telemetry.decode_begin = Profiling::Now();
+					std::unordered_map<StringID, std::shared_ptr<Resource>> contents;
+					{
+						PROFILE_DURATION("DecodePackageSource", Streaming);
+						contents = std::visit([this, &token, &current](auto& source) { return database.CreateContents(source, token, current->work_done); }, *current->source);
+					}
+					current->telemetry.decode_end = Profiling::Now();
+					current->telemetry.num_resources = contents.size();
+
+					std::shared_ptr<Package> package;
+					{
+						PROFILE_DURATION("PublishPackage", Streaming);
+						package = database.CreatePackageWithContents(current->name, contents);
+					}
+					current->telemetry.published = Profiling::Now();
 
-				//Always notify listeners once the request is complete, even if it's a failure.
-				current->ts_result.Notify();
+					FinishRequest(current, package);
 
-				auto requests = ts_requests.LockExclusive();
-				requests->erase(current->name);
+				} catch (std::exception const& e) {
+					FinishRequest(current, std::unexpected<std::string>(e.what()));
+				}
 			}
 		}
 	}
 
-	PackageRequestHandle StreamingDatabase::AsyncRequestThread::CreateRequest(StringID name, RequestPriority priority) {
-		auto requests = ts_requests.LockExclusive();
-
-		//Attempt to find the package if it's already loaded.
-		//We do this while the streaming is locked to avoid a race condition if multiple LoadPackage calls are made at the same time.
+	PackageRequestHandle StreamingDatabase::AsyncRequestQueue::CreateRequest(StringID name, RequestPriority priority) {
+		std::shared_ptr<PackageRequest> created;
 		{
-			auto const packages = database.ts_packages.LockInclusive();
-			auto const iter = packages->find(name);
+			auto pending = ts_pending.LockExclusive();
 
-			if (iter != packages->end()) {
-				auto const request = std::make_shared<PackageRequest>(iter->second);
-				return PackageRequestHandle{ request };
+			//Attempt to find the package if it's already loaded.
+			//We do this while the streaming is locked to avoid a race condition if multiple LoadPackage calls are made at the same time.
+			{
+				auto const packages = database.ts_packages.LockInclusive();
+				auto const iter = packages->find(name);
+
+				if (iter != packages->end()) {
+					auto const request = std::make_shared<PackageRequest>(iter->second);
+					return PackageRequestHandle{ request };
+				}
 			}
-		}
 
-		//Attempt to find an existing streaming object for this package, and update the priority based on this new request
-		auto const iter = requests->find(name);
-		if (iter != requests->end()) {
-			//@todo Increase the priority to the maximum value of all requests
-			return PackageRequestHandle{ iter->second };
+			//Attempt to find an existing streaming object for this package, and update the priority based on this new request
+			if (std::shared_ptr<PackageRequest> const existing = FindPendingRequest(*pending, name)) {
+				RaisePriority(*pending, *existing, priority);
+				return PackageRequestHandle{ existing };
+			}
 
 			//Create a new streaming object for this package, and notify waiting threads that a new streaming package was added.
-		} else {
-			auto const result = requests->emplace(std::make_pair(name, std::make_shared<PackageRequest>(name, priority)));
-			ts_requests.Notify();
-			return PackageRequestHandle{ result.first->second };
+			created = std::make_shared<PackageRequest>(name, priority);
+			pending->requests.emplace(name, created);
+			pending->read_queue.Push(*created);
+			ts_pending.Notify();
 		}
+
+		EstimateWork(*created);
+		return PackageRequestHandle{ created };
 	}
 
-	std::shared_ptr<PackageRequest> StreamingDatabase::AsyncRequestThread::GetHighestPriorityRequest(std::stop_token& token) const {
-		//We'll lock only as long as it takes to process the current streaming packages and choose one to update.
-		auto const requests = ts_requests.WaitInclusive([&token](auto const& requests) { return requests.size() > 0 || token.stop_requested(); });
+	StreamingStatistics StreamingDatabase::AsyncRequestQueue::GetStatistics() const {
+		StreamingStatistics statistics;
+		{
+			auto const pending = ts_pending.LockInclusive();
+			statistics.num_queued = pending->read_queue.size();
+			statistics.num_prefetched = pending->num_prefetched;
+		}
+
+		//Copy the telemetry so the percentiles can be calculated without holding the lock
+		std::vector<PackageRequestTelemetry> recent;
+		{
+			auto const finished = ts_finished.LockInclusive();
+			statistics.num_loaded = finished->num_loaded;
+			statistics.num_failed = finished->num_failed;
+			statistics.num_bytes = finished->num_bytes;
+			statistics.num_resources = finished->num_resources;
+			statistics.max_queued = std::max(finished->max_queued, statistics.num_queued);
+			statistics.max_prefetched = std::max(finished->max_prefetched, statistics.num_prefetched);
+			recent.assign(finished->recent.begin(), finished->recent.end());
+		}
+
+		std::vector<Profiling::DurationType> durations;
+		durations.reserve(recent.size());
+		auto const calculate = [&](Profiling::TimePointType PackageRequestTelemetry::* begin, Profiling::TimePointType PackageRequestTelemetry::* end) {
+			durations.clear();
+			for (PackageRequestTelemetry const& telemetry : recent) durations.emplace_back(telemetry.*end - telemetry.*begin);
+			return CalculatePercentiles(durations);
+		};
+
+		statistics.queued = calculate(&PackageRequestTelemetry::queued, &PackageRequestTelemetry::read_begin);
+		statistics.reading = calculate(&PackageRequestTelemetry::read_begin, &PackageRequestTelemetry::read_end);
+		statistics.waiting = calculate(&PackageRequestTelemetry::read_end, &PackageRequestTelemetry::decode_begin);
+		statistics.decoding = calculate(&PackageRequestTelemetry::decode_begin, &PackageRequestTelemetry::decode_end);
+		statistics.publishing = calculate(&PackageRequestTelemetry::decode_end, &PackageRequestTelemetry::published);
+		statistics.total = calculate(&PackageRequestTelemetry::queued, &PackageRequestTelemetry::published);
+
+		return statistics;
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::ResetStatistics() {
+		auto finished = ts_finished.LockExclusive();
+		*finished = FinishedRequests{};
+	}
+
+	bool StreamingDatabase::AsyncRequestQueue::PendingRequests::CanRead() const {
+		//Limit how far reading can get ahead of decoding, so sources don't accumulate in memory.
+		//If none of the sources that were already read can be decoded, they must be waiting on a dependency that hasn't been read yet, so reading continues.
+		if (num_prefetched >= MaxPrefetchedSources && CanDecode()) return false;
+		return !read_queue.empty();
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::WakeAll() {
+		//Waiting threads will not see the stop request unless they are woken up.
+		//Briefly taking the lock ensures a thread cannot miss the notification between checking the token and starting to wait.
+		{ auto const pending = ts_pending.LockInclusive(); }
+		ts_pending.Notify();
+	}
+
+	std::shared_ptr<PackageRequest> StreamingDatabase::AsyncRequestQueue::ClaimRequest(std::stop_token& token, EPackageRequestStage next) {
+		bool const reading = next == EPackageRequestStage::Reading;
+
+		//We'll lock only as long as it takes to take the highest-priority request from the queue for this stage.
+		//Other threads may advance requests while we wait, which can make more requests available.
+		auto pending = ts_pending.WaitExclusive([&](PendingRequests const& pending) {
+			return token.stop_requested() || (reading ? pending.CanRead() : pending.CanDecode());
+		});
 
 		//If we stopped waiting because of a shutdown, don't return a package.
-		if (token.stop_requested() || requests->size() == 0) return nullptr;
+		if (token.stop_requested()) return nullptr;
+
+		PackageRequest& available = (reading ? pending->read_queue : pending->decode_queue).Pop();
+
+		//Requests are reaped when they are taken from a queue, rather than as soon as they are canceled or abandoned.
+		//Returning nullptr lets the calling thread claim the next request instead.
+		if (IsUnwanted(available)) {
+			ReapRequest(*pending, available);
+			ts_pending.Notify();
+			return nullptr;
+		}
+
+		available.stage = next;
+		//Claiming a request can change which requests are available to other stages, such as allowing more sources to be prefetched.
+		ts_pending.Notify();
+		return pending->requests.at(available.name);
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::SampleQueueDepth() {
+		size_t num_queued = 0;
+		size_t num_prefetched = 0;
+		{
+			auto const pending = ts_pending.LockInclusive();
+			num_queued = pending->read_queue.size();
+			num_prefetched = pending->num_prefetched;
+		}
+
+		{
+			auto finished = ts_finished.LockExclusive();
+			finished->max_queued = std::max(finished->max_queued, num_queued);
+			finished->max_prefetched = std::max(finished->max_prefetched, num_prefetched);
+		}
+
+		PROFILE_COUNTER("StreamingQueued", Streaming, num_queued);
+		PROFILE_COUNTER("StreamingPrefetched", Streaming, num_prefetched);
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::RecordFinishedRequest(PackageRequest const& request, bool loaded) {
+		{
+			auto finished = ts_finished.LockExclusive();
+			if (loaded) {
+				++finished->num_loaded;
+				finished->num_bytes += request.telemetry.num_bytes;
+				finished->num_resources += request.telemetry.num_resources;
 
-		//@todo Clean the list of requests by removing requests that have no external references (ref_count is 1).
+				finished->recent.emplace_back(request.telemetry);
+				if (finished->recent.size() > MaxStreamingHistory) finished->recent.pop_front();
 
-		//Now find the highest-priority request. This is the request that we should be trying to fulfill.
-		RequestPriority highest_priority = 0;
-		std::shared_ptr<PackageRequest> highest_request;
+			} else {
+				++finished->num_failed;
+			}
+		}
+
+#ifndef DISABLE_PROFILING
+		//The whole request spans several threads, so it is reported as a single event once it is finished rather than with a scope
+		if (loaded) {
+			PackageRequestTelemetry const& telemetry = request.telemetry;
+			Profiling::Profiler::Get().WriteDurationEvent(Format("StreamPackage {}", request.name), ProfileStreaming, telemetry.queued, telemetry.published - telemetry.queued);
+		}
+#endif
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::FinishRequest(std::shared_ptr<PackageRequest> const& request, PackageRequest::Result result) {
+		RecordFinishedRequest(*request, result.has_value());
+		request->CompleteWork();
+
+		{
+			//Canceled requests already have a result, which should not be replaced
+			auto const locked_result = request->ts_result.LockExclusive();
+			if (!locked_result->has_value()) locked_result->emplace(std::move(result));
+		}
+		//Always notify listeners once the request is complete, even if it's a failure.
+		request->ts_result.Notify();
+
+		auto pending = ts_pending.LockExclusive();
+		RemoveRequest(*pending, *request);
+
+		//Wake up any idle threads. Finishing a request may have unblocked other requests that depend on it.
+		ts_pending.Notify();
+	}
 
-		auto iter = requests->begin();
+	void StreamingDatabase::AsyncRequestQueue::ReapRequest(PendingRequests& pending, PackageRequest& request) {
 		{
-			highest_priority = iter->second->priority;
-			highest_request = iter->second;
-			++iter;
-		}
-		for (; iter != requests->end(); ++iter) {
-			if (iter->second->priority > highest_priority) {
-				highest_priority = iter->second->priority;
-				highest_request = iter->second;
+			auto const locked_result = request.ts_result.LockExclusive();
+			if (!locked_result->has_value()) locked_result->emplace(std::unexpected<std::string>("Request was canceled"));
+		}
+		RecordFinishedRequest(request, false);
+		request.CompleteWork();
+		request.cancellation.request_stop();
+		request.ts_result.Notify();
+
+		RemoveRequest(pending, request);
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::RemoveRequest(PendingRequests& pending, PackageRequest& request) {
+		if (request.stage == EPackageRequestStage::Read || request.stage == EPackageRequestStage::Decoding) --pending.num_prefetched;
+		pending.read_queue.Remove(request);
+		pending.decode_queue.Remove(request);
+		request.stage = EPackageRequestStage::Finished;
+
+		//Requests that were waiting on this one may now be ready to decode. Failed dependencies do not prevent dependents from being decoded.
+		for (PackageRequest* dependent : request.dependents) {
+			if (--dependent->num_pending_dependencies == 0 && dependent->stage == EPackageRequestStage::Read) {
+				pending.decode_queue.Push(*dependent);
 			}
 		}
+		request.dependents.clear();
+
+		//This request is no longer waiting on its dependencies, so it should not be referenced by them.
+		//Dependencies that were only needed by this request can be reaped, but only after this request is fully removed.
+		std::vector<StringID> released;
+		for (std::shared_ptr<PackageRequest> const& dependency : request.dependencies) {
+			if (std::erase(dependency->dependents, &request) > 0) released.emplace_back(dependency->name);
+		}
+
+		//The source is no longer needed once the request is finished, and may be holding onto a large amount of memory.
+		request.source.reset();
+
+		//A canceled request may have been replaced by a newer request with the same name, which must remain.
+		//This may destroy the request, so it must not be used after this point.
+		auto const iter = pending.requests.find(request.name);
+		if (iter != pending.requests.end() && iter->second.get() == &request) pending.requests.erase(iter);
+
+		for (StringID const name : released) {
+			auto const dependency = pending.requests.find(name);
+			if (dependency == pending.requests.end()) continue;
+
+			//Dependencies that are in progress will be reaped by the thread processing them once that stage is complete
+			EPackageRequestStage const stage = dependency->second->stage;
+			bool const in_progress = stage == EPackageRequestStage::Reading || stage == EPackageRequestStage::Decoding;
+			if (!in_progress && IsUnwanted(*dependency->second)) ReapRequest(pending, *dependency->second);
+		}
+	}
+
+	std::shared_ptr<PackageRequest> StreamingDatabase::AsyncRequestQueue::FindPendingRequest(PendingRequests& pending, StringID name) {
+		auto const iter = pending.requests.find(name);
+		if (iter == pending.requests.end()) return nullptr;
+
+		std::shared_ptr<PackageRequest> const request = iter->second;
+		if (!request->IsCanceled()) return request;
+
+		//A canceled request will never produce a package, so it should not be shared with new requests for the same package.
+		//If it is in progress, it is only detached here and the thread processing it will remove it once that stage is complete.
+		if (request->stage == EPackageRequestStage::Reading || request->stage == EPackageRequestStage::Decoding) pending.requests.erase(iter);
+		else ReapRequest(pending, *request);
+		return nullptr;
+	}
 
-		return highest_request;
+	void StreamingDatabase::AsyncRequestQueue::EstimateWork(PackageRequest& request) {
+		//The source may already have been read by the time the estimate is available, in which case the exact size is kept
+		uint64_t expected = 0;
+		request.work_total.compare_exchange_strong(expected, database.EstimatePackageSourceSize(request.name) * 2);
 	}
 
-	std::vector<std::shared_ptr<PackageRequest>> StreamingDatabase::AsyncRequestThread::CreateDependencyRequests(std::unordered_set<StringID> const& dependencies) {
-		if (dependencies.size() > 0) {
+	void StreamingDatabase::AsyncRequestQueue::AssignDependencyRequests(PackageRequest& request, std::unordered_set<StringID> const& dependencies) {
+		//Requests created for dependencies that were not already loaded or pending, which need an estimate of their work once the requests are unlocked
+		std::vector<std::shared_ptr<PackageRequest>> created;
+
+		{
 			//Lock before iterating to make sure new requests cannot be filed while we are creating each dependency request.
-			auto requests = ts_requests.LockExclusive();
-			auto const packages = database.ts_packages.LockInclusive();
+			//Dependencies and dependents are used to determine when requests can be decoded, so they can only be assigned while locked.
+			auto pending = ts_pending.LockExclusive();
+
+			//The request may have been canceled or abandoned while it was being read, in which case it shouldn't create any more requests.
+			if (IsUnwanted(request)) {
+				ReapRequest(*pending, request);
+				ts_pending.Notify();
+				return;
+			}
+
+			if (dependencies.size() > 0) {
+				auto const packages = database.ts_packages.LockInclusive();
+				RequestPriority const priority = request.priority;
 
-			std::vector<std::shared_ptr<PackageRequest>> results;
-			ranges::transform(
-				dependencies, std::back_inserter(results),
-				[&requests, &packages](StringID name) {
+				for (StringID const name : dependencies) {
 					//Attempt to find the package if it's already loaded.
 					{
 						auto const iter = packages->find(name);
 
 						if (iter != packages->end()) {
-							return std::make_shared<PackageRequest>(iter->second);
+							request.dependencies.emplace_back(std::make_shared<PackageRequest>(iter->second));
+							continue;
 						}
 					}
 
-					//Attempt to find an existing streaming object for this package
-					auto const iter = requests->find(name);
-					if (iter != requests->end()) {
-						return iter->second;
+					//Attempt to find an existing streaming object for this package. It must be loaded before this package, so it inherits this priority.
+					if (std::shared_ptr<PackageRequest> const existing = FindPendingRequest(*pending, name)) {
+						PackageRequest& dependency = *existing;
+
+						//A package that already depends on this one would never be decoded if this one also waited for it, so the cycle is broken here.
+						if (&dependency == &request || DependsOn(dependency, request)) {
+							LOG(Resources, Warning, "Package {} has a circular dependency on package {}, which will be ignored while streaming", request.name, name);
+							continue;
+						}
+
+						RaisePriority(*pending, dependency, priority);
+						request.dependencies.emplace_back(existing);
+
+					} else {
+						//Create a new streaming object for this package.
+						//We don't notify here, waiting threads are notified once all dependencies are assigned.
+						auto const result = pending->requests.emplace(std::make_pair(name, std::make_shared<PackageRequest>(name, priority)));
+						pending->read_queue.Push(*result.first->second);
+						request.dependencies.emplace_back(result.first->second);
+						created.emplace_back(result.first->second);
 					}
+				}
+			}
+			//The dependencies will not change after this point, so they can be read without locking to calculate progress
+			request.has_dependencies.store(true, std::memory_order_release);
+
+			for (std::shared_ptr<PackageRequest> const& dependency : request.dependencies) {
+				if (dependency->stage != EPackageRequestStage::Finished) {
+					dependency->dependents.emplace_back(&request);
+					++request.num_pending_dependencies;
+				}
+			}
+
+			request.stage = EPackageRequestStage::Read;
+			++pending->num_prefetched;
+			if (request.num_pending_dependencies == 0) pending->decode_queue.Push(request);
+
+			ts_pending.Notify();
+		}
+
+		for (std::shared_ptr<PackageRequest> const& dependency : created) EstimateWork(*dependency);
+	}
+
+	void StreamingDatabase::AsyncRequestQueue::RaisePriority(PendingRequests& pending, PackageRequest& request, RequestPriority priority) {
+		//Priorities only increase, so this will stop at requests that were already raised even if the dependencies contain a cycle.
+		if (request.stage == EPackageRequestStage::Finished || priority <= request.priority) return;
+
+		request.priority = priority;
+		pending.read_queue.Update(request);
+		pending.decode_queue.Update(request);
+
+		for (std::shared_ptr<PackageRequest> const& dependency : request.dependencies) {
+			RaisePriority(pending, *dependency, priority);
+		}
+	}
+
+	bool StreamingDatabase::AsyncRequestQueue::IsUnwanted(PackageRequest const& request) {
+		if (request.IsCanceled()) return true;
+		if (request.num_handles > 0) return false;
+		return ranges::all_of(request.dependents, [](PackageRequest const* dependent) { return IsUnwanted(*dependent); });
+	}
+
+	StreamingDurationPercentiles StreamingDatabase::AsyncRequestQueue::CalculatePercentiles(std::vector<Profiling::DurationType>& durations) {
+		StreamingDurationPercentiles percentiles;
+		if (durations.empty()) return percentiles;
+
+		ranges::sort(durations);
+		auto const at = [&](size_t percent) { return durations[(durations.size() - 1) * percent / 100]; };
+
+		percentiles.p50 = at(50);
+		percentiles.p90 = at(90);
+		percentiles.p99 = at(99);
+		percentiles.max = durations.back();
+		return percentiles;
+	}
+
+	bool StreamingDatabase::AsyncRequestQueue::DependsOn(PackageRequest const& request, PackageRequest const& other) {
+		std::unordered_set<PackageRequest const*> visited;
+		std::vector<PackageRequest const*> stack{ &request };
+
+		while (stack.size() > 0) {
+			PackageRequest const* current = stack.back();
+			stack.pop_back();
 
-					//Create a new streaming object for this package.
-					//We don't notify because this happens within the processing thread already, this can never wake the processing thread.
-					auto const result = requests->emplace(std::make_pair(name, std::make_shared<PackageRequest>(name, LowestRequestPriority)));
-					return result.first->second;
+			for (std::shared_ptr<PackageRequest> const& dependency : current->dependencies) {
+				if (dependency.get() == &other) return true;
+				if (dependency->stage != EPackageRequestStage::Finished && visited.insert(dependency.get()).second) stack.emplace_back(dependency.get());
+			}
+		}
+		return false;
+	}
+
+	StreamingDatabase::AsyncSaveQueue::AsyncSaveQueue(StreamingDatabase& database)
+		: database(database)
+	{}
+
+	void StreamingDatabase::AsyncSaveQueue::operator()(std::stop_token token) {
+		std::stop_callback const wake_on_stop{ token, [this]() {
+			{ auto const pending = ts_pending.LockInclusive(); }
+			ts_pending.Notify();
+		} };
+
+		while (true) {
+			std::shared_ptr<PackageSaveRequest> current;
+			{
+				auto pending = ts_pending.WaitExclusive([&](PendingSaves const& pending) {
+					return token.stop_requested() || pending.queue.size() > 0;
+				});
+
+				//Pending saves are finished even when stopping, so changes are not lost when the database is destroyed
+				if (pending->queue.empty()) return;
+
+				current = pending->queue.front();
+				pending->queue.pop_front();
+				pending->current = current;
+			}
+
+			try {
+				database.SavePackageContents(current->name, current->contents, current->progress);
+				current->progress = 1.0f;
+
+				auto result = current->ts_result.LockExclusive();
+				result->emplace();
+
+			} catch (std::exception const& e) {
+				{
+					auto result = current->ts_result.LockExclusive();
+					result->emplace(std::unexpected<std::string>(e.what()));
 				}
-			);
-			return results;
+
+				//The package still has changes that were not saved
+				if (std::shared_ptr<Package> const package = database.FindPackage(current->name)) package->flags += EPackageFlags::Dirty;
+			}
+
+			//The snapshot may be keeping resources alive, and is no longer needed
+			current->contents.clear();
+			current->ts_result.Notify();
+
+			{
+				auto pending = ts_pending.LockExclusive();
+				pending->current.reset();
+			}
+			ts_pending.Notify();
+		}
+	}
+
+	PackageSaveHandle StreamingDatabase::AsyncSaveQueue::CreateRequest(StringID name, Package::ContentsContainerType contents) {
+		auto pending = ts_pending.LockExclusive();
+
+		//If this package is already waiting to be saved, the newer snapshot replaces the older one so the package is only saved once
+		auto const iter = ranges::find(pending->queue, name, [](std::shared_ptr<PackageSaveRequest> const& request) { return request->name; });
+		if (iter != pending->queue.end()) {
+			(*iter)->contents = std::move(contents);
+			return PackageSaveHandle{ *iter };
+		}
+
+		auto const request = std::make_shared<PackageSaveRequest>(name, std::move(contents));
+		pending->queue.emplace_back(request);
+		ts_pending.Notify();
+		return PackageSaveHandle{ request };
+	}
+
+	void StreamingDatabase::AsyncSaveQueue::CancelRequest(StringID name) {
+		std::shared_ptr<PackageSaveRequest> canceled;
+		{
+			auto pending = ts_pending.LockExclusive();
+
+			auto const iter = ranges::find(pending->queue, name, [](std::shared_ptr<PackageSaveRequest> const& request) { return request->name; });
+			if (iter != pending->queue.end()) {
+				canceled = *iter;
+				pending->queue.erase(iter);
+			}
+		}
+
+		if (canceled) {
+			{
+				auto result = canceled->ts_result.LockExclusive();
+				result->emplace(std::unexpected<std::string>("Save was canceled"));
+			}
+			canceled->contents.clear();
+			canceled->ts_result.Notify();
+
+			//The package still has changes that were not saved, the same as when a save fails
+			if (std::shared_ptr<Package> const package = database.FindPackage(name)) package->flags += EPackageFlags::Dirty;
 		}
 
-		return {};
+		//A save that has already started cannot be interrupted, so wait until it is finished
+		auto const pending = ts_pending.WaitInclusive([name](PendingSaves const& pending) { return !pending.current || pending.current->name != name; });
 	}
 }
@@ -1,21 +1,102 @@
 #pragma once
 #include "Engine/Array.h"
 #include "Engine/Core.h"
+#include "Engine/IntrusiveHeap.h"
 #include "Engine/Map.h"
 #include "Engine/Optional.h"
 #include "Engine/SmartPointers.h"
 #include "Engine/StringID.h"
 #include "Engine/Threads.h"
+#include "Profiling/ProfilerMacros.h"
 #include "Resources/Database.h"
 #include "Resources/Package.h"
 #include "Resources/PackageIO.h"
 
 namespace Resources {
+	DECLARE_PROFILE_CATEGORY(Streaming);
+
 	using RequestPriority = uint16_t;
 	constexpr RequestPriority DefaultRequestPriority = 1000;
 	constexpr RequestPriority LowestRequestPriority = 0;
 	constexpr RequestPriority HighestRequestPriority = std::numeric_limits<RequestPriority>::max();
 
+	/** The stages that a package request moves through while it is streamed */
+	enum class EPackageRequestStage : uint8_t {
+		/** Waiting for the source of the package to be read */
+		Queued,
+		/** The source of the package is being read by the I/O stage */
+		Reading,
+		/** The source of the package was read, and it is waiting for its dependencies before it can be decoded */
+		Read,
+		/** The contents of the package are being decoded and published by a worker */
+		Decoding,
+		/** The request has a result and is no longer pending */
+		Finished,
+	};
+
+	/** Timestamps and sizes recorded as a package request moves through the streaming stages */
+	struct PackageRequestTelemetry {
+		/** When the request was created */
+		Profiling::TimePointType queued;
+		/** When the I/O stage started reading the source */
+		Profiling::TimePointType read_begin;
+		/** When the I/O stage finished reading the source */
+		Profiling::TimePointType read_end;
+		/** When a worker started decoding the source, after all dependencies were finished */
+		Profiling::TimePointType decode_begin;
+		/** When a worker finished creating the resources in the package */
+		Profiling::TimePointType decode_end;
+		/** When the package was added to the database */
+		Profiling::TimePointType published;
+
+		/** The number of bytes in the source of the package */
+		size_t num_bytes = 0;
+		/** The number of resources that were created for the package */
+		size_t num_resources = 0;
+	};
+
+	/** The distribution of a duration that was measured for many streamed packages */
+	struct StreamingDurationPercentiles {
+		Profiling::DurationType p50 = Profiling::DurationType::zero();
+		Profiling::DurationType p90 = Profiling::DurationType::zero();
+		Profiling::DurationType p99 = Profiling::DurationType::zero();
+		Profiling::DurationType max = Profiling::DurationType::zero();
+	};
+
+	/** Statistics about packages that were streamed, used to find out why loading is slow and to compare loads with each other */
+	struct StreamingStatistics {
+		/** The number of packages that were loaded successfully */
+		size_t num_loaded = 0;
+		/** The number of requests that finished without a package, including requests that were canceled */
+		size_t num_failed = 0;
+		/** The total number of bytes read from package sources */
+		size_t num_bytes = 0;
+		/** The total number of resources that were created in loaded packages */
+		size_t num_resources = 0;
+
+		/** The time each request waited before its source started being read */
+		StreamingDurationPercentiles queued;
+		/** The time taken to read each source */
+		StreamingDurationPercentiles reading;
+		/** The time each source waited after being read before it started being decoded, which includes waiting for dependencies */
+		StreamingDurationPercentiles waiting;
+		/** The time taken to decode each source and create its resources */
+		StreamingDurationPercentiles decoding;
+		/** The time taken to add each package to the database once its resources were created */
+		StreamingDurationPercentiles publishing;
+		/** The time from each request being created until its package was added to the database */
+		StreamingDurationPercentiles total;
+
+		/** The number of requests that are currently waiting for their source to be read */
+		size_t num_queued = 0;
+		/** The number of requests that currently have a source that was read but not decoded */
+		size_t num_prefetched = 0;
+		/** The largest number of requests that were waiting for their source to be read at the same time */
+		size_t max_queued = 0;
+		/** The largest number of requests that had a source that was read but not decoded at the same time */
+		size_t max_prefetched = 0;
+	};
+
 	/** A request to load a specific package. Used internally as part of the streaming process. */
 	struct PackageRequest {
 		using Result = std::expected<std::shared_ptr<Package>, std::string>;
@@ -23,23 +104,63 @@ namespace Resources {
 		/** The name of the package being requested. Cannot change after the request is made, each request may only refer to a single package. */
 		StringID const name;
 
-		/** The priority at which the package is being requested. The priority can increase if a higher-priority request is made, but cannot decrease. */
+		/** The priority at which the package is being requested. The priority can increase if a higher-priority request is made, but cannot decrease. Only modified while the streaming requests are locked. */
 		std::atomic<RequestPriority> priority = DefaultRequestPriority;
-		/** An approximation of the progress of loading this package. Does not include the progress of loading dependencies. */
+		/** The highest progress that was reported for this package and its dependencies, which prevents the reported progress from going backwards */
 		std::atomic<float> progress = 0.0f;
+		/** The amount of work that was completed for this package alone, measured in bytes of its source */
+		std::atomic<uint64_t> work_done = 0;
+		/**
+		 * The total amount of work needed to load this package alone. Reading the source and creating its resources each count for the full size of the source.
+		 * This is an estimate until the source is read, and is zero if the size of the source cannot be estimated.
+		 */
+		std::atomic<uint64_t> work_total = 0;
+		/** The number of external handles that refer to this request. Requests without handles are only loaded if another wanted request depends on them. */
+		std::atomic<size_t> num_handles = 0;
+		/** Stops the streaming of this package when a cancellation is requested */
+		std::stop_source cancellation;
 
 		/** The source information being read to create the package. Available once the package has started the process of loading. */
 		std::optional<PackageInput> source;
-		/** The set of first-level dependencies that must be loaded before this package can be loaded */
+		/** The current stage of this request. Only accessed while the streaming requests are locked. */
+		EPackageRequestStage stage = EPackageRequestStage::Queued;
+		/** The set of first-level dependencies that must be loaded before this package can be loaded. Cannot change once it has been assigned. */
 		std::vector<std::shared_ptr<PackageRequest>> dependencies;
+		/** Whether the dependencies have been assigned, which allows them to be read without locking the streaming requests */
+		std::atomic<bool> has_dependencies = false;
+		/** The pending requests which have this request as a dependency. Only accessed while the streaming requests are locked. */
+		std::vector<PackageRequest*> dependents;
+		/** The number of dependencies which are not finished yet. Only accessed while the streaming requests are locked. */
+		size_t num_pending_dependencies = 0;
+		/** The position of this request within the streaming queue it is waiting in. Only accessed while the streaming requests are locked. */
+		size_t queue_position = std::numeric_limits<size_t>::max();
 		/** The final result of this request, which is created only when it is finished. Some requests are created in an already-finished state, and this will be immediately available. */
 		TriggeredThreadSafe<std::optional<Result>> ts_result;
+		/** Timing information for this request. Each stage is recorded by the thread that processes it, and is read once the request is finished. */
+		PackageRequestTelemetry telemetry;
 
-		PackageRequest(StringID name, RequestPriority priority) : name(name), priority(priority) {}
-		PackageRequest(std::shared_ptr<Package> package) : name(package->GetName()), progress(1.0f), ts_result(package.get()) {}
+		PackageRequest(StringID name, RequestPriority priority)
+			: name(name), priority(priority), telemetry{ .queued = Profiling::Now() }
+		{}
+		PackageRequest(std::shared_ptr<Package> package)
+			: name(package->GetName()), progress(1.0f), work_done(1), work_total(1), stage(EPackageRequestStage::Finished), has_dependencies(true), ts_result(package.get())
+		{}
 
 		/** True if this request is still pending and does not have a result yet */
 		inline bool IsPending() const { return !ts_result.LockInclusive()->has_value(); }
+		/** True if a cancellation was requested for this request */
+		inline bool IsCanceled() const { return cancellation.stop_requested(); }
+
+		/** Get the completed and total work for this package alone. A package without an estimate counts as a single unit of work until it is read. */
+		inline std::pair<uint64_t, uint64_t> GetWork() const {
+			uint64_t const total = std::max<uint64_t>(work_total, 1);
+			return std::make_pair(std::min<uint64_t>(work_done, total), total);
+		}
+		/** Mark all the work for this package as complete, which happens when it finishes for any reason */
+		inline void CompleteWork() {
+			work_total = std::max<uint64_t>(work_total, 1);
+			work_done = work_total.load();
+		}
 	};
 
 	/**
@@ -48,25 +169,35 @@ namespace Resources {
 	 * They do not have a default state, a handle instance will always refer to a request that was made.
 	 */
 	struct PackageRequestHandle {
-		PackageRequestHandle(std::shared_ptr<PackageRequest> request) : request(request) {}
-		PackageRequestHandle(PackageRequestHandle const&) = default;
+		PackageRequestHandle(std::shared_ptr<PackageRequest> request) : request(std::move(request)) { ++this->request->num_handles; }
+		PackageRequestHandle(PackageRequestHandle const& other) : PackageRequestHandle(other.request) {}
 		PackageRequestHandle(PackageRequestHandle&&) = default;
+		~PackageRequestHandle() { if (request) --request->num_handles; }
 
-		PackageRequestHandle& operator=(PackageRequestHandle const&) = default;
-		PackageRequestHandle& operator=(PackageRequestHandle&&) = default;
+		PackageRequestHandle& operator=(PackageRequestHandle other) { std::swap(request, other.request); return *this; }
 
 		inline bool operator==(PackageRequestHandle const& other) const { return request->name == other.request->name; }
 
 		/** Get the name of the package that this streaming object is loading */
 		inline StringID GetName() const { return request->name; }
-		/** Get the progress of loading this package expressed as a ratio between 0 and 1 */
-		inline float GetProgress() const { return request->progress; }
+		/**
+		 * Get the progress of loading this package and all of its nested dependencies, expressed as a ratio between 0 and 1.
+		 * Progress is measured in bytes of each source that were read and decoded. Calculated without locking, so it is safe to call frequently.
+		 */
+		float GetProgress() const;
 
 		/** True if the streaming failed at some point for the package, meaning this streaming object will no longer result in a final package. */
 		bool HasFailed() const;
 		/** Get the package if it is already loaded. Will return nullptr if the package is not loaded, or if streaming did not finish. */
 		std::shared_ptr<Package> Get() const;
 
+		/**
+		 * Cancel the request, which will immediately fail for every handle that refers to it. Does nothing if the request already has a result.
+		 * Work on the request stops at the next opportunity, and dependencies that are not needed by any other request are canceled as well.
+		 * Requests that depend on this one will continue loading without it, the same as if it had failed.
+		 */
+		void Cancel();
+
 		/** Block and wait until the package is finished loading, then return the result */
 		std::shared_ptr<Package> Wait();
 		/** Block and wait until the package is finished loading or the specified time, then return the result */
@@ -81,44 +212,245 @@ namespace Resources {
 		static inline bool IsResultReady(std::optional<PackageRequest::Result> const& result) { return result.has_value(); }
 	};
 
+	/** A request to save a specific package. Used internally as part of the streaming process. */
+	struct PackageSaveRequest {
+		using Result = std::expected<void, std::string>;
+
+		/** The name of the package being saved */
+		StringID const name;
+
+		/** An approximation of the progress of saving this package */
+		std::atomic<float> progress = 0.0f;
+		/** A snapshot of the contents of the package that will be saved. Replaced if the package is saved again before this request starts. Only accessed while the pending saves are locked, or by the saving thread once it has started. */
+		Package::ContentsContainerType contents;
+		/** The final result of this request, which is created only when it is finished */
+		TriggeredThreadSafe<std::optional<Result>> ts_result;
+
+		PackageSaveRequest(StringID name, Package::ContentsContainerType contents) : name(name), contents(std::move(contents)) {}
+	};
+
+	/**
+	 * A handle that allows external access to a particular package save request.
+	 * Multiple saves of the same package may share a request if they are made before the package starts saving.
+	 */
+	struct PackageSaveHandle {
+		PackageSaveHandle(std::shared_ptr<PackageSaveRequest> request) : request(request) {}
+		PackageSaveHandle(PackageSaveHandle const&) = default;
+		PackageSaveHandle(PackageSaveHandle&&) = default;
+
+		PackageSaveHandle& operator=(PackageSaveHandle const&) = default;
+		PackageSaveHandle& operator=(PackageSaveHandle&&) = default;
+
+		/** Get the name of the package that is being saved */
+		inline StringID GetName() const { return request->name; }
+		/** Get the progress of saving this package expressed as a ratio between 0 and 1 */
+		inline float GetProgress() const { return request->progress; }
+
+		/** True if the save is finished, whether it succeeded or failed */
+		bool IsFinished() const;
+		/** True if the save failed or was canceled. Get the error describing the failure, if there is one. */
+		std::optional<std::string> GetError() const;
+
+		/** Block and wait until the package is finished saving. Returns true if the package was saved successfully. */
+		bool Wait();
+		/** Block and wait until the package is finished saving or the specified time. Returns true if the package was saved successfully. */
+		bool Wait(std::chrono::high_resolution_clock::time_point time);
+		/** Block and wait until the package is finished saving or the duration has elapsed. Returns true if the package was saved successfully. */
+		bool Wait(std::chrono::milliseconds duration);
+
+	private:
+		std::shared_ptr<PackageSaveRequest> request;
+
+		/** Helper that returns true if the result has a value assigned */
+		static inline bool IsResultReady(std::optional<PackageSaveRequest::Result> const& result) { return result.has_value(); }
+	};
+
 	/** A database which supports streaming operations to load and save packages. Loading and saving is asynchronous. */
 	struct StreamingDatabase : public Database {
-		StreamingDatabase();
+		StreamingDatabase(size_t num_workers = GetDefaultWorkerCount());
+
+		/** Get the default number of worker threads that will decode streamed packages */
+		static size_t GetDefaultWorkerCount();
+
+		/** The maximum number of package sources that can be read ahead of the workers that decode them */
+		static constexpr size_t MaxPrefetchedSources = 16;
+		/** The maximum number of resources read from a text package before they are deserialized, which limits the memory used by their nodes */
+		static constexpr size_t MaxPendingTextResources = 64;
+		/** The number of recently loaded packages that are used to calculate the percentiles in streaming statistics */
+		static constexpr size_t MaxStreamingHistory = 1024;
+
+		/** Get statistics about the packages that were streamed since the database was created or the statistics were last reset */
+		StreamingStatistics GetStreamingStats() const;
+		/** Reset the streaming statistics, so that a following load can be measured on its own */
+		void ResetStreamingStats();
 
 	protected:
-		/** Save a known package. The location of the saved source and the format in which it is saved is determined by the implementer. */
-		virtual bool SavePackage(Package const& package) = 0;
+		/** Estimate the size of the source for a known package, which is used to report progress before the source is read. Returns zero if the size cannot be estimated. */
+		virtual size_t EstimatePackageSourceSize(StringID name) const { return 0; }
+		/**
+		 * Save the contents of a known package. The location of the saved source and the format in which it is saved is determined by the implementer.
+		 * Called from the saving thread, and should throw if the package cannot be saved. The progress can be updated as the package is saved.
+		 */
+		virtual void SavePackageContents(StringID name, Package::ContentsContainerType const& contents, std::atomic<float>& progress) = 0;
 		/** Load the source for a known package. The location of the source and the format in which it is returned is determined by the implementer. */
 		virtual PackageInput LoadPackageSource(StringID name) = 0;
 
-		/** Save an existing package that has the provided name. If the package does not exist, an exception will be thrown. */
+		/** Stop all streaming threads, after finishing any pending saves. Must be called by implementers when they are destroyed, since the threads call their methods. */
+		void StopStreaming();
+
+		/** Save an existing package that has the provided name, blocking until it is saved. If the package does not exist, an exception will be thrown. */
 		bool SavePackage(StringID name);
+		/**
+		 * Save an existing package that has the provided name on the saving thread. If the package does not exist, an exception will be thrown.
+		 * The contents of the package are captured immediately. If the package is saved again before saving starts, the saves are combined.
+		 */
+		PackageSaveHandle SavePackageAsync(StringID name);
+		/** Cancel a pending save of the package, or wait for it to finish if it has already started */
+		void CancelSave(StringID name);
 		/** Load an existing package that has the provided name. If the package is already loaded, a handle to the loaded package will be returned instead. */
 		PackageRequestHandle LoadPackage(StringID name, RequestPriority priority = DefaultRequestPriority);
 
+		/**
+		 * Replace the contents of a loaded package with a source that was read again, such as after the source was changed outside of the engine.
+		 * Resources whose serialized data did not change are left untouched. Changed resources are deserialized in place, and observers are notified that they were updated.
+		 * Resources that were added to the source are created, and resources that were removed from the source are moved to the temporary package.
+		 * Returns the number of resources that were updated, created, or removed.
+		 */
+		size_t ReloadPackageContents(std::shared_ptr<Package> const& package, PackageInput& source);
+
 	private:
-		struct AsyncRequestThread {
-			AsyncRequestThread(StreamingDatabase& database);
+		/**
+		 * Processes pending requests in stages. A single I/O thread reads package sources ahead of time in priority order,
+		 * while a pool of worker threads decodes the contents of packages once their dependencies are loaded and publishes them.
+		 */
+		struct AsyncRequestQueue {
+			AsyncRequestQueue(StreamingDatabase& database);
 
-			void operator()(std::stop_token token);
+			/** Run the I/O stage, which reads the sources of queued requests until the token is stopped */
+			void ReadSources(std::stop_token token);
+			/** Run the decode stage, which creates the contents of requests whose dependencies are loaded until the token is stopped */
+			void DecodeSources(std::stop_token token);
 
 			PackageRequestHandle CreateRequest(StringID name, RequestPriority priority);
 
+			StreamingStatistics GetStatistics() const;
+			void ResetStatistics();
+
 		private:
-			using ThreadSafeRequestsContainer = TriggeredThreadSafe<std::unordered_map<StringID, std::shared_ptr<PackageRequest>>>;
+			struct PriorityProjection {
+				inline RequestPriority operator()(PackageRequest const& request) const { return request.priority.load(std::memory_order_relaxed); }
+			};
+			using RequestQueue = IntrusiveHeap<PackageRequest, PriorityProjection, &PackageRequest::queue_position>;
+
+			/** The state of all pending requests, which is shared by the streaming threads */
+			struct PendingRequests {
+				/** All requests that do not have a result yet */
+				std::unordered_map<StringID, std::shared_ptr<PackageRequest>> requests;
+				/** Requests that are waiting for their source to be read */
+				RequestQueue read_queue;
+				/** Requests that were read and have no pending dependencies, so they are ready to be decoded */
+				RequestQueue decode_queue;
+				/** The number of requests which have a source that was read, but is not finished decoding yet */
+				size_t num_prefetched = 0;
+
+				/** True if the I/O stage should read another source */
+				bool CanRead() const;
+				/** True if a worker can decode a source */
+				inline bool CanDecode() const { return !decode_queue.empty(); }
+			};
+			using ThreadSafePendingRequests = TriggeredThreadSafe<PendingRequests>;
+
+			/** Telemetry from requests that were finished, which is aggregated into streaming statistics */
+			struct FinishedRequests {
+				/** The telemetry of the most recently loaded packages, oldest first */
+				std::deque<PackageRequestTelemetry> recent;
+				size_t num_loaded = 0;
+				size_t num_failed = 0;
+				size_t num_bytes = 0;
+				size_t num_resources = 0;
+				size_t max_queued = 0;
+				size_t max_prefetched = 0;
+			};
 
 			StreamingDatabase& database;
-			ThreadSafeRequestsContainer ts_requests;
+			ThreadSafePendingRequests ts_pending;
+			ThreadSafe<FinishedRequests> ts_finished;
+			/** The total number of bytes that were read from package sources, which is reported as a profiling counter */
+			std::atomic<uint64_t> total_bytes_read = 0;
+
+			/** Wake up all threads that are waiting for requests, so they can observe a stop request */
+			void WakeAll();
 
-			std::shared_ptr<PackageRequest> GetHighestPriorityRequest(std::stop_token& token) const;
-			std::vector<std::shared_ptr<PackageRequest>> CreateDependencyRequests(std::unordered_set<StringID> const& dependencies);
+			/** Wait until a request can be moved to the next stage, and move it. Returns nullptr if the thread is stopping. */
+			std::shared_ptr<PackageRequest> ClaimRequest(std::stop_token& token, EPackageRequestStage next);
+			/** Sample the depth of each queue and report it as profiling counters */
+			void SampleQueueDepth();
+			/** Record the telemetry of a request that has a result, and report it as profiling events */
+			void RecordFinishedRequest(PackageRequest const& request, bool loaded);
+
+			/** Assign the result of a request and remove it from the pending requests */
+			void FinishRequest(std::shared_ptr<PackageRequest> const& request, PackageRequest::Result result);
+			/** Cancel a request that is no longer wanted and remove it from the pending requests. The request must not be in progress. */
+			void ReapRequest(PendingRequests& pending, PackageRequest& request);
+			/** Remove a request from the pending requests, and reap any dependencies that are no longer wanted as a result */
+			void RemoveRequest(PendingRequests& pending, PackageRequest& request);
+			/** Find a pending request with the provided name. Canceled requests are discarded, so a new request can be created in their place. */
+			std::shared_ptr<PackageRequest> FindPendingRequest(PendingRequests& pending, StringID name);
+
+			/** Estimate the work for a new request from the size of its source. Estimating may access the filesystem, so this is only done for new requests and never while locked. */
+			void EstimateWork(PackageRequest& request);
+			/** Assign the dependencies of a request that was read, making it available to be decoded once those dependencies are finished */
+			void AssignDependencyRequests(PackageRequest& request, std::unordered_set<StringID> const& dependencies);
+
+			/** True if the request was canceled, or if it has no handles and every request that depends on it is also unwanted */
+			static bool IsUnwanted(PackageRequest const& request);
+
+			/** Raise the priority of a pending request and all of its nested dependencies. Priorities are never lowered. */
+			static void RaisePriority(PendingRequests& pending, PackageRequest& request, RequestPriority priority);
+			/** True if the request depends on the other request, either directly or through nested dependencies */
+			static bool DependsOn(PackageRequest const& request, PackageRequest const& other);
+
+			/** Calculate the percentiles of durations that were measured for each loaded package. The durations are sorted in place. */
+			static StreamingDurationPercentiles CalculatePercentiles(std::vector<Profiling::DurationType>& durations);
 		};
 
-		AsyncRequestThread async_request_thread;
-		std::jthread thread;
+		/** Processes pending saves in the order they were requested. Saves that are still pending when stopping are finished before the thread exits. */
+		struct AsyncSaveQueue {
+			AsyncSaveQueue(StreamingDatabase& database);
+
+			void operator()(std::stop_token token);
+
+			PackageSaveHandle CreateRequest(StringID name, Package::ContentsContainerType contents);
+			void CancelRequest(StringID name);
+
+		private:
+			struct PendingSaves {
+				/** Saves that have not started yet, in the order they were requested */
+				std::deque<std::shared_ptr<PackageSaveRequest>> queue;
+				/** The save that is currently in progress */
+				std::shared_ptr<PackageSaveRequest> current;
+			};
+
+			StreamingDatabase& database;
+			TriggeredThreadSafe<PendingSaves> ts_pending;
+		};
+
+		AsyncRequestQueue async_requests;
+		AsyncSaveQueue async_saves;
+		std::jthread read_thread;
+		std::vector<std::jthread> decode_threads;
+		std::jthread save_thread;
 
 		std::shared_ptr<Resource> CreateResource(StringID id, Reflection::StructTypeInfo const& type, absl::FunctionRef<void(Resource&)> initializer);
-		std::unordered_map<StringID, std::shared_ptr<Resource>> CreateContents(PackageInput_Binary& source);
-		std::unordered_map<StringID, std::shared_ptr<Resource>> CreateContents(PackageInput_YAML& source);
+		std::vector<std::shared_ptr<Resource>> CreateResourceBatch(Reflection::StructTypeInfo const& type, std::span<StringID const> ids, absl::FunctionRef<void(Resource&, size_t)> initializer);
+		std::unordered_map<StringID, std::shared_ptr<Resource>> CreateContents(PackageInput_Binary& source, std::stop_token token, std::atomic<uint64_t>& work_done);
+		std::unordered_map<StringID, std::shared_ptr<Resource>> CreateContents(PackageInput_YAML& source, std::stop_token token, std::atomic<uint64_t>& work_done);
+
+		size_t ReloadContents(std::shared_ptr<Package> const& package, PackageInput_Binary& source);
+		size_t ReloadContents(std::shared_ptr<Package> const& package, PackageInput_YAML& source);
+		/** Create a resource that was added to a reloaded package, replacing an existing resource with the same name that has a different type */
+		void ReplaceReloadedResource(std::shared_ptr<Package> const& package, std::shared_ptr<Resource> const& existing, StringID id, Reflection::StructTypeInfo const& type, absl::FunctionRef<void(Resource&)> initializer);
+		/** Remove resources from a reloaded package that are no longer in its source. Returns the number of resources that were removed. */
+		size_t RemoveReloadedResources(std::shared_ptr<Package> const& package, std::unordered_set<StringID> const& reloaded);
 	};
 }
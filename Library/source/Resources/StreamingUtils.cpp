@@ -1,4 +1,5 @@
 #include "Resources/StreamingUtils.h"
+#include "Engine/Archive.h"
 #include "Engine/Reflection.h"
 #include "Engine/StringID.h"
 #include "Resources/Database.h"
@@ -57,4 +58,18 @@ namespace Resources {
 		}
 	}
 
+	std::vector<std::byte> CreateResourceDelta(Resource const& resource, Resource const& base) {
+		Reflection::StructTypeInfo const& type = resource.GetTypeInfo();
+		if (base.GetTypeInfo() != type) throw FormatType<std::runtime_error>("Cannot create a patch for resource {}, the base is a different type", resource.GetName());
+
+		std::vector<std::byte> bytes;
+		Archive::Output archive{ bytes };
+		Reflection::StructSerializationHelpers::SerializeDelta(type, archive, &resource, &base);
+		return bytes;
+	}
+
+	void ApplyResourceDelta(Resource& resource, std::span<std::byte const> delta) {
+		Archive::Input archive{ delta };
+		Reflection::StructSerializationHelpers::DeserializeDelta(resource.GetTypeInfo(), archive, &resource);
+	}
 }
@@ -17,4 +17,9 @@ namespace Resources {
 	std::unordered_set<StringID> GatherPackageDependencies(Package::ContentsContainerType const& contents);
 	/** Gather the packages on which the provided instance depends */
 	void GatherPackageDependencies(Reflection::StructTypeInfo const& type, void const* instance, std::unordered_set<StringID>& dependencies);
+
+	/** Create a patch that contains only the variables of the resource that differ from the base, such as a previously saved version of the resource. The base must have the same type. */
+	std::vector<std::byte> CreateResourceDelta(Resource const& resource, Resource const& base);
+	/** Apply a patch to a resource that matches the base the patch was created from */
+	void ApplyResourceDelta(Resource& resource, std::span<std::byte const> delta);
 }